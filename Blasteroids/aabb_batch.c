@@ -0,0 +1,165 @@
+//
+//  aabb_batch.c
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/01.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+#include "aabb_batch.h"
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AABB_BATCH_X86 1
+#include <immintrin.h>
+#endif
+
+typedef int (*AabbBatchFunction)(const float*, const float*, const float*, const float*, int, float, float, float, float, uint32_t*);
+
+/*
+ Scalar kernel, also does the tail the SIMD kernels leave (less than 4 or 8 boxes), from box start on.
+ Written as "not greater" and "not less" so NaN gives the same answer as _BBOX_collide_or_not().
+ */
+int _aabb_batch_scalar_from(const float* min_x, const float* min_y, const float* max_x, const float* max_y, int start, int count,
+                            float q_min_x, float q_min_y, float q_max_x, float q_max_y,
+                            uint32_t* hit_masks)
+{
+    int hits = 0;
+    for (int i = start; i < count; i++) {
+        if (min_x[i] > q_max_x) continue;
+        if (max_x[i] < q_min_x) continue;
+        if (min_y[i] > q_max_y) continue;
+        if (max_y[i] < q_min_y) continue;
+        hit_masks[i >> 5] |= (uint32_t)1 << (i & 31);
+        hits++;
+    }
+    return hits;
+}
+
+int _aabb_batch_scalar(const float* min_x, const float* min_y, const float* max_x, const float* max_y, int count,
+                       float q_min_x, float q_min_y, float q_max_x, float q_max_y,
+                       uint32_t* hit_masks)
+{
+    memset(hit_masks, 0, ((count + 31) >> 5) * sizeof(uint32_t));
+    return _aabb_batch_scalar_from(min_x, min_y, max_x, max_y, 0, count, q_min_x, q_min_y, q_max_x, q_max_y, hit_masks);
+}
+
+#if defined(AABB_BATCH_X86) && defined(__SSE2__)
+int _aabb_batch_sse2(const float* min_x, const float* min_y, const float* max_x, const float* max_y, int count,
+                     float q_min_x, float q_min_y, float q_max_x, float q_max_y,
+                     uint32_t* hit_masks)
+{
+    memset(hit_masks, 0, ((count + 31) >> 5) * sizeof(uint32_t));
+    __m128 qx0 = _mm_set1_ps(q_min_x), qy0 = _mm_set1_ps(q_min_y);
+    __m128 qx1 = _mm_set1_ps(q_max_x), qy1 = _mm_set1_ps(q_max_y);
+    int hits = 0;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        // hit = !(min_x > q_max_x) && !(max_x < q_min_x) && !(min_y > q_max_y) && !(max_y < q_min_y)
+        __m128 hit = _mm_and_ps(_mm_cmpngt_ps(_mm_loadu_ps(min_x + i), qx1), _mm_cmpnlt_ps(_mm_loadu_ps(max_x + i), qx0));
+        hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpngt_ps(_mm_loadu_ps(min_y + i), qy1), _mm_cmpnlt_ps(_mm_loadu_ps(max_y + i), qy0)));
+        uint32_t bits = (uint32_t)_mm_movemask_ps(hit);
+        hit_masks[i >> 5] |= bits << (i & 31);
+        hits += __builtin_popcount(bits);
+    }
+    return hits + _aabb_batch_scalar_from(min_x, min_y, max_x, max_y, i, count, q_min_x, q_min_y, q_max_x, q_max_y, hit_masks);
+}
+#endif
+
+#if defined(AABB_BATCH_X86)
+__attribute__((target("avx2")))
+int _aabb_batch_avx2(const float* min_x, const float* min_y, const float* max_x, const float* max_y, int count,
+                     float q_min_x, float q_min_y, float q_max_x, float q_max_y,
+                     uint32_t* hit_masks)
+{
+    memset(hit_masks, 0, ((count + 31) >> 5) * sizeof(uint32_t));
+    __m256 qx0 = _mm256_set1_ps(q_min_x), qy0 = _mm256_set1_ps(q_min_y);
+    __m256 qx1 = _mm256_set1_ps(q_max_x), qy1 = _mm256_set1_ps(q_max_y);
+    int hits = 0;
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // unordered predicates, so NaN counts as "not greater"/"not less", same as the scalar one.
+        __m256 hit = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(min_x + i), qx1, _CMP_NGT_UQ), _mm256_cmp_ps(_mm256_loadu_ps(max_x + i), qx0, _CMP_NLT_UQ));
+        hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(min_y + i), qy1, _CMP_NGT_UQ), _mm256_cmp_ps(_mm256_loadu_ps(max_y + i), qy0, _CMP_NLT_UQ)));
+        uint32_t bits = (uint32_t)_mm256_movemask_ps(hit);
+        hit_masks[i >> 5] |= bits << (i & 31);
+        hits += __builtin_popcount(bits);
+    }
+    return hits + _aabb_batch_scalar_from(min_x, min_y, max_x, max_y, i, count, q_min_x, q_min_y, q_max_x, q_max_y, hit_masks);
+}
+#endif
+
+static AabbBatchFunction selected_function = NULL;
+static AabbKernel selected_kernel = AABB_KERNEL_SCALAR;
+
+bool _aabb_batch_supported(AabbKernel kernel)
+{
+    switch (kernel) {
+        case AABB_KERNEL_SCALAR:
+            return true;
+        case AABB_KERNEL_SSE2:
+#if defined(AABB_BATCH_X86) && defined(__SSE2__)
+            return true;
+#else
+            return false;
+#endif
+        case AABB_KERNEL_AVX2:
+#if defined(AABB_BATCH_X86)
+            return __builtin_cpu_supports("avx2");
+#else
+            return false;
+#endif
+        default:
+            return false;
+    }
+}
+
+AabbKernel aabb_batch_select(AabbKernel kernel)
+{
+    // auto, or not supported: try from the widest down.
+    if (kernel == AABB_KERNEL_AUTO || !_aabb_batch_supported(kernel)) {
+        kernel = _aabb_batch_supported(AABB_KERNEL_AVX2) ? AABB_KERNEL_AVX2 : (_aabb_batch_supported(AABB_KERNEL_SSE2) ? AABB_KERNEL_SSE2 : AABB_KERNEL_SCALAR);
+    }
+    switch (kernel) {
+#if defined(AABB_BATCH_X86)
+        case AABB_KERNEL_AVX2:
+            selected_function = _aabb_batch_avx2;
+            break;
+#endif
+#if defined(AABB_BATCH_X86) && defined(__SSE2__)
+        case AABB_KERNEL_SSE2:
+            selected_function = _aabb_batch_sse2;
+            break;
+#endif
+        default:
+            kernel = AABB_KERNEL_SCALAR;
+            selected_function = _aabb_batch_scalar;
+            break;
+    }
+    selected_kernel = kernel;
+    return kernel;
+}
+
+const char* aabb_batch_kernel_name(void)
+{
+    if (!selected_function) {
+        aabb_batch_select(AABB_KERNEL_AUTO);
+    }
+    switch (selected_kernel) {
+        case AABB_KERNEL_AVX2: return "avx2";
+        case AABB_KERNEL_SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+int aabb_batch_overlap(const float* min_x, const float* min_y, const float* max_x, const float* max_y, int count,
+                       float query_min_x, float query_min_y, float query_max_x, float query_max_y,
+                       uint32_t* hit_masks)
+{
+    // pick the best kernel on first use.
+    if (!selected_function) {
+        aabb_batch_select(AABB_KERNEL_AUTO);
+    }
+    return selected_function(min_x, min_y, max_x, max_y, count, query_min_x, query_min_y, query_max_x, query_max_y, hit_masks);
+}
@@ -0,0 +1,57 @@
+//
+//  aabb_batch.h
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/01.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+/*
+ Batch bounding box test: one query box against many boxes at once.
+ 
+ Boxes are packed in 4 arrays (min_x, min_y, max_x, max_y), so SIMD could load 4 (SSE2) or 8 (AVX2) of them in one go.
+ The result is a bitmask, bit i of hit_masks is set if box i overlaps the query box. Bit i lives in word i/32, at bit i%32.
+ 
+ Kernels:
+    scalar -- plain loop, works everywhere.
+    sse2   -- 4 boxes per instruction, baseline of every x86-64 cpu.
+    avx2   -- 8 boxes per instruction, only when the cpu has it.
+ The best one is picked at runtime on first use. All of them give bit-identical masks, the test is the same as _BBOX_collide_or_not() (touching counts as overlap), NaN included.
+ */
+
+#ifndef aabb_batch_h
+#define aabb_batch_h
+
+#include <stdio.h>
+#include <stdint.h>
+
+typedef enum {
+    AABB_KERNEL_AUTO,   // best one this cpu supports.
+    AABB_KERNEL_SCALAR,
+    AABB_KERNEL_SSE2,
+    AABB_KERNEL_AVX2
+} AabbKernel;
+
+/*
+ Test the query box against count boxes, write ceil(count/32) words of bitmask to hit_masks.
+ 
+ Return how many boxes overlap.
+ */
+int aabb_batch_overlap(const float* min_x, const float* min_y, const float* max_x, const float* max_y, int count,
+                       float query_min_x, float query_min_y, float query_max_x, float query_max_y,
+                       uint32_t* hit_masks);
+
+/*
+ Choose the kernel used by aabb_batch_overlap(). If the cpu doesn't support it, fall back to the best one it does.
+ 
+ Return the kernel actually selected.
+ */
+AabbKernel aabb_batch_select(AabbKernel kernel);
+
+/*
+ Name of the kernel in use, for logs and benchmarks.
+ */
+const char* aabb_batch_kernel_name(void);
+
+
+#endif /* aabb_batch_h */
@@ -8,207 +8,466 @@
 
 
 #include "asteroids.h"
+#include <string.h>
 
 
-int asteroid_draw(Asteroid* asteroid)
+// the outline, drawn at origin, line i goes from point i to point i+1, the last one back to the first.
+static const float asteroid_outline[ASTEROID_OUTLINE_POINTS][2] = {
+    {-20, 20}, {-25, 5}, {-25, -10}, {-5, -10}, {-10, -20}, {5, -20},
+    {20, -10}, {20, -5}, {0, 0}, {20, 10}, {10, 20}, {0, 15}
+};
+
+// in asteroid's own space, it's scaled with the asteroid.
+#define ASTEROID_LINE_WIDTH 2.0f
+
+/*
+ Expand each line of the outline to a quad once, so drawing needs no sqrt.
+ */
+int _asteroid_cluster_build_outline(AsteroidCluster* ac)
 {
-    // set transform
-    ALLEGRO_TRANSFORM transform;
-    al_identity_transform(&transform);
-    // which comes first which comes late matters.
-    al_scale_transform(&transform, asteroid->scale, asteroid->scale);
-    al_rotate_transform(&transform, DEGTORAD(asteroid->twist));
-    al_translate_transform(&transform, asteroid->x, asteroid->y);
-    al_use_transform(&transform);
-    
-    // draw at origin.
-    al_draw_line(-20, 20, -25, 5, asteroid->color, 2.0f);
-    al_draw_line(-25, 5, -25, -10, asteroid->color, 2.0f);
-    al_draw_line(-25, -10, -5, -10, asteroid->color, 2.0f);
-    al_draw_line(-5, -10, -10, -20, asteroid->color, 2.0f);
-    al_draw_line(-10, -20, 5, -20, asteroid->color, 2.0f);
-    al_draw_line(5, -20, 20, -10, asteroid->color, 2.0f);
-    al_draw_line(20, -10, 20, -5, asteroid->color, 2.0f);
-    al_draw_line(20, -5, 0, 0, asteroid->color, 2.0f);
-    al_draw_line(0, 0, 20, 10, asteroid->color, 2.0f);
-    al_draw_line(20, 10, 10, 20, asteroid->color, 2.0f);
-    al_draw_line(10, 20, 0, 15, asteroid->color, 2.0f);
-    al_draw_line(0, 15, -20, 20, asteroid->color, 2.0f);
+    for (int l = 0; l < ASTEROID_OUTLINE_POINTS; l++) {
+        const float* p = asteroid_outline[l];
+        const float* q = asteroid_outline[(l + 1) % ASTEROID_OUTLINE_POINTS];
+        float dx = q[0] - p[0];
+        float dy = q[1] - p[1];
+        float length = sqrtf(dx * dx + dy * dy);
+        // half thickness, perpendicular to the line.
+        float nx = -dy / length * ASTEROID_LINE_WIDTH / 2;
+        float ny = dx / length * ASTEROID_LINE_WIDTH / 2;
+        float (*quad)[2] = &ac->outline_quads[l * 4];
+        quad[0][0] = p[0] + nx; quad[0][1] = p[1] + ny;
+        quad[1][0] = q[0] + nx; quad[1][1] = q[1] + ny;
+        quad[2][0] = q[0] - nx; quad[2][1] = q[1] - ny;
+        quad[3][0] = p[0] - nx; quad[3][1] = p[1] - ny;
+    }
+    return 0;
+}
+
+/*
+ Add asteroid i to batch: scale, rotate, translate every corner of the outline on cpu, the same transform al_use_transform() would do.
+ */
+int asteroid_draw(AsteroidCluster* ac, int i, float alpha, PrimBatch* batch)
+{
+    // in between last step and this one. Last step it was one velocity * last_dt back, the short way if it just went across an edge.
+    float back = (1 - alpha) * ac->last_dt;
+    float tx = lerp_wrapped_f(ac->x[i] - ac->vx[i] * ac->last_dt, ac->x[i], alpha, BUFFER_WIDTH);
+    float ty = lerp_wrapped_f(ac->y[i] - ac->vy[i] * ac->last_dt, ac->y[i], alpha, BUFFER_HEIGHT);
+    // it has spun for spin_time since its twist, rot_velocity is per 1/GAME_FPS tick.
+    float twist = DEGTORAD(fmod(ac->twist[i] + ac->rot_velocity[i] * GAME_FPS * (ac->spin_time - back), 360.0));
+    // rotation and scale together.
+    float c = cosf(twist) * ac->scale[i];
+    float s = sinf(twist) * ac->scale[i];
     
+    for (int l = 0; l < ASTEROID_OUTLINE_POINTS; l++) {
+        float (*quad)[2] = &ac->outline_quads[l * 4];
+        float x[4], y[4];
+        for (int k = 0; k < 4; k++) {
+            x[k] = quad[k][0] * c - quad[k][1] * s + tx;
+            y[k] = quad[k][0] * s + quad[k][1] * c + ty;
+        }
+        prim_batch_add_quad(batch, x[0], y[0], x[1], y[1], x[2], y[2], x[3], y[3], ac->color);
+    }
     return 0;
 }
 
-int asteroid_update(Asteroid* asteroid)
+/*
+ Asteroid i shows twist (in degree) now, keep it as its twist at spin_time 0.
+ */
+int _asteroid_set_twist(AsteroidCluster* ac, int i, float twist)
+{
+    double phase = fmod(twist - ac->rot_velocity[i] * GAME_FPS * ac->spin_time, 360.0);
+    ac->twist[i] = phase < 0 ? phase + 360.0 : phase;
+    return 0;
+}
+
+int asteroid_update(AsteroidCluster* ac, int i, float dt)
 {
     // OFF screen, it should appear on the other side of screen.
-    asteroid->x = asteroid->x < 0 ? (asteroid->x + BUFFER_WIDTH) : ( asteroid->x > BUFFER_WIDTH ? (asteroid->x - BUFFER_WIDTH) : asteroid->x );
-    asteroid->y = asteroid->y < 0 ? (asteroid->y + BUFFER_HEIGHT) : ( asteroid->y > BUFFER_HEIGHT ? (asteroid->y - BUFFER_HEIGHT) :  asteroid->y );
+    ac->x[i] = ac->x[i] < 0 ? (ac->x[i] + BUFFER_WIDTH) : ( ac->x[i] > BUFFER_WIDTH ? (ac->x[i] - BUFFER_WIDTH) : ac->x[i] );
+    ac->y[i] = ac->y[i] < 0 ? (ac->y[i] + BUFFER_HEIGHT) : ( ac->y[i] > BUFFER_HEIGHT ? (ac->y[i] - BUFFER_HEIGHT) :  ac->y[i] );
     
-    // rotate itself
-    asteroid->twist += asteroid->rot_velocity;
-    // if it's over 360, mod it
-    asteroid->twist = fmod(asteroid->twist, 360);
+    // no rotating here, it only shows when drawn, see asteroid_draw().
     
-    // move towards heading.
-    asteroid->x += asteroid->speed * (1.0/GAME_FPS) * sin(DEGTORAD(asteroid->heading));
-    asteroid->y -= asteroid->speed * (1.0/GAME_FPS) * cos(DEGTORAD(asteroid->heading));
+    // move with its velocity.
+    ac->x[i] += ac->vx[i] * dt;
+    ac->y[i] += ac->vy[i] * dt;
     
     return 0;
 }
 
-Asteroid* asteroid_create(float x,
-                          float y,
-                          float heading,   // in degree, 0-360
-                          float twist,    // in degree, 0-360
-                          float speed,    // in px/second
-                          float rot_velocity, // in degree, 0-360/second
-                          float scale,
-                          int life_left)
-{
-    Asteroid* new_asteroid = malloc(sizeof(Asteroid));
-    new_asteroid->x = x;
-    new_asteroid->y = y;
-    new_asteroid->heading = heading <0 ? (heading+360.0) : fmod(heading, 360.0);
-    new_asteroid->twist = twist <0 ? (twist+360.0) : fmod(twist, 360.0);
-    new_asteroid->speed = speed;
-    new_asteroid->rot_velocity = rot_velocity;
-    new_asteroid->scale = scale;
-    new_asteroid->life_left = life_left;
-    new_asteroid->color = al_map_rgb(255, 255, 255);
-    // it's callers responsibility to assign it to a node and cluster.
-    new_asteroid->node_ref = NULL;
-    return new_asteroid;
-}
-
-Asteroid* asteroid_create_random()
-{
-    float random_x = random_between_f(1.0, (float)BUFFER_WIDTH);
-    float random_y = random_between_f(1.0, (float)BUFFER_HEIGHT);
-    float random_heading = random_between_f(0.0, 360.0);    // heading
-    float random_twist = random_between_f(0.0, 360.0);    // twist
-    float random_speed = random_between_f(0.0, ASTEROID_MAX_SPEED);   // speed in degree
-    float random_rotational_speed = random_between_f(0.0, ASTEROID_MAX_ROT_SPEED);  // rotational speed
-    float random_scale = random_between_f(ASTEROID_DEFAULT_SCALE_FACTOR_MIN, ASTEROID_DEFAULT_SCALE_FACTOR_MAX); // scale factor
-    int random_life = random_between(1, ASTEROID_BASE_LIFE);    // random life of asteroid.
-    // new asteroid, with randoms, and 1 for scale, 0 for hit times.
-    Asteroid* random_asteroid = asteroid_create(random_x, random_y, random_heading, random_twist, random_speed, random_rotational_speed, random_scale, random_life);
-    return random_asteroid;
+// cluster basic operations.
+
+/*
+ Point every array into arena, capacity elements each, in this order.
+ */
+int _asteroid_cluster_bind(AsteroidCluster* ac, char* arena, int capacity)
+{
+    size_t stride = capacity * 4;
+    ac->arena = arena;
+    // hot
+    ac->x = (float*)(arena + 0 * stride);
+    ac->y = (float*)(arena + 1 * stride);
+    ac->vx = (float*)(arena + 2 * stride);
+    ac->vy = (float*)(arena + 3 * stride);
+    ac->scale = (float*)(arena + 4 * stride);
+    // cold
+    ac->twist = (float*)(arena + 5 * stride);
+    ac->rot_velocity = (float*)(arena + 6 * stride);
+    ac->life_left = (int*)(arena + 7 * stride);
+    ac->capacity = capacity;
+    return 0;
 }
 
-// cluster basic operations.
+/*
+ Grow every array to new_capacity, the asteroids in it are kept.
+ */
+int _asteroid_cluster_grow(AsteroidCluster* ac, int new_capacity)
+{
+    // on a cache line, so are all the arrays, capacity is a multiple of 16. Workers updating next to each other never share a line.
+    char* arena = NULL;
+    if (posix_memalign((void**)&arena, ASTEROID_ARENA_ALIGN, (size_t)new_capacity * ASTEROID_ARRAY_COUNT * 4) != 0) {
+        go_error("Failed when growing asteroid cluster, out of memory.");
+    }
+    // each array moves to its new place, only the part in use.
+    if (ac->arena) {
+        for (int k = 0; k < ASTEROID_ARRAY_COUNT; k++) {
+            memcpy(arena + (size_t)k * new_capacity * 4, (char*)ac->arena + (size_t)k * ac->capacity * 4, (size_t)ac->count * 4);
+        }
+        free(ac->arena);
+    }
+    _asteroid_cluster_bind(ac, arena, new_capacity);
+    handle_table_reserve(&ac->handles, new_capacity);
+    ac->heap_calls++;
+    return 0;
+}
+
+int _asteroid_cluster_count_peak(AsteroidCluster* ac)
+{
+    if (ac->count > ac->high_water) {
+        ac->high_water = ac->count;
+    }
+    return 0;
+}
+
+size_t asteroid_cluster_packed_size(AsteroidCluster* ac)
+{
+    return (size_t)ac->count * ASTEROID_ARRAY_COUNT * 4 + handle_table_packed_size(&ac->handles, ac->count);
+}
+
+int asteroid_cluster_pack(AsteroidCluster* ac, void* dst)
+{
+    // the spare room after count is left out, so it's count sized however big the cluster once was.
+    size_t size = (size_t)ac->count * 4;
+    for (int k = 0; k < ASTEROID_ARRAY_COUNT; k++) {
+        memcpy((char*)dst + k * size, (char*)ac->arena + (size_t)k * ac->capacity * 4, size);
+    }
+    handle_table_pack(&ac->handles, (char*)dst + ASTEROID_ARRAY_COUNT * size, ac->count, 0, ac->capacity);
+    return 0;
+}
+
+int asteroid_cluster_unpack(AsteroidCluster* ac, const void* src, int count)
+{
+    if (count > ac->capacity) {
+        int new_capacity = ac->capacity ? ac->capacity : 64;
+        while (new_capacity < count) {
+            new_capacity *= 2;
+        }
+        // nothing in it is kept.
+        ac->count = 0;
+        _asteroid_cluster_grow(ac, new_capacity);
+    }
+    size_t size = (size_t)count * 4;
+    for (int k = 0; k < ASTEROID_ARRAY_COUNT; k++) {
+        memcpy((char*)ac->arena + (size_t)k * ac->capacity * 4, (const char*)src + k * size, size);
+    }
+    ac->count = count;
+    _asteroid_cluster_count_peak(ac);
+    handle_table_unpack(&ac->handles, (const char*)src + ASTEROID_ARRAY_COUNT * size, count);
+    return 0;
+}
 
 int asteroid_cluster_init(AsteroidCluster* ac)
 {
-    generic_cluster_init(ac);
+    ac->arena = NULL;
+    ac->count = 0;
+    ac->capacity = 0;
+    ac->spin_time = 0;
+    ac->last_dt = 0;
+    ac->high_water = 0;
+    ac->heap_calls = 0;
+    ac->color = al_map_rgb(255, 255, 255);
+    ac->split_cos = cos(DEGTORAD(ASTEROID_DEFAULT_SPLIT_DEGREE));
+    ac->split_sin = sin(DEGTORAD(ASTEROID_DEFAULT_SPLIT_DEGREE));
+    _asteroid_cluster_build_outline(ac);
+    handle_table_init(&ac->handles, 0);
+    _asteroid_cluster_grow(ac, ASTEROID_CLUSTER_INIT_CAPACITY);
     return 0;
 }
 
 int asteroid_cluster_destroy(AsteroidCluster* ac)
 {
-    generic_cluster_destroy(ac);
+    free(ac->arena);
+    handle_table_release(&ac->handles);
+    free(ac);
     return 0;
 }
 
 
-int asteroid_cluster_add_asteroid(AsteroidCluster* ac, Asteroid* asteroid)
+Handle asteroid_cluster_add_asteroid(AsteroidCluster* ac,
+                                  float x,
+                                  float y,
+                                  float heading,   // in degree, 0-360
+                                  float twist,    // in degree, 0-360
+                                  float speed,    // in px/second
+                                  float rot_velocity, // in degree, per 1/GAME_FPS tick
+                                  float scale,
+                                  int life_left)
 {
-    AsteroidClusterNode* new_node = generic_cluster_add_node(ac, asteroid);
-    // ref back to the new node.
-    if (new_node) {
-        asteroid->node_ref = new_node;
-    } else {
-        go_error("Failed when adding new asteroid to asteroid cluster, newly created cluster node is NULL.");
+    // full, double the room.
+    if (ac->count == ac->capacity) {
+        _asteroid_cluster_grow(ac, ac->capacity * 2);
     }
-    return 0;
+    int i = ac->count;
+    ac->x[i] = x;
+    ac->y[i] = y;
+    // 0 degree is north, screen y goes down, so it's -cos for y.
+    ac->vx[i] = speed * sinf(DEGTORAD(heading));
+    ac->vy[i] = -speed * cosf(DEGTORAD(heading));
+    ac->rot_velocity[i] = rot_velocity;
+    _asteroid_set_twist(ac, i, twist);
+    ac->scale[i] = scale;
+    ac->life_left[i] = life_left;
+    ac->count++;
+    _asteroid_cluster_count_peak(ac);
+    return handle_table_add(&ac->handles, i);
 }
 
+Handle asteroid_cluster_handle(AsteroidCluster* ac, int index)
+{
+    return handle_table_get(&ac->handles, index);
+}
 
+int asteroid_cluster_find(AsteroidCluster* ac, Handle asteroid)
+{
+    return handle_table_find(&ac->handles, asteroid);
+}
 
-int asteroid_cluster_remove_asteroid_node(AsteroidCluster* ac, AsteroidClusterNode* node_to_remove)
+/*
+ Remove the asteroid at index, its handles go stale, the last one's handles follow it to index.
+ */
+int _asteroid_cluster_remove_at(AsteroidCluster* ac, int index)
 {
-    generic_cluster_remove_node(ac, node_to_remove);
+    handle_table_remove(&ac->handles, index);
+    // move the last one into this hole, so arrays stay packed.
+    int last = ac->count - 1;
+    if (index != last) {
+        handle_table_move(&ac->handles, last, index);
+        ac->x[index] = ac->x[last];
+        ac->y[index] = ac->y[last];
+        ac->vx[index] = ac->vx[last];
+        ac->vy[index] = ac->vy[last];
+        ac->twist[index] = ac->twist[last];
+        ac->rot_velocity[index] = ac->rot_velocity[last];
+        ac->scale[index] = ac->scale[last];
+        ac->life_left[index] = ac->life_left[last];
+    }
+    ac->count--;
     return 0;
 }
 
+int asteroid_cluster_remove_asteroid(AsteroidCluster* ac, Handle asteroid)
+{
+    int index = handle_table_find(&ac->handles, asteroid);
+    if (index < 0) {
+        return -1;
+    }
+    return _asteroid_cluster_remove_at(ac, index);
+}
 
 
 
 // public operations
 
-// random asteroid creation.
-int asteroid_cluster_add_a_random_asteroid(AsteroidCluster* all_asteroids)
+// random asteroid creation, the batch of one, so the same rng gives the same asteroid either way.
+int asteroid_cluster_add_a_random_asteroid(AsteroidCluster* all_asteroids, Rng* rng)
 {
-    // make a brand new random asteroid.
-    Asteroid* random_asteroid = asteroid_create_random();
-    // add it into cluster.
-    asteroid_cluster_add_asteroid(all_asteroids, random_asteroid);
-    return 0;
+    return asteroid_cluster_add_some_random_asteroids(all_asteroids, 1, rng);
 }
 
-int asteroid_cluster_add_some_random_asteroids(AsteroidCluster* all_asteroids, int total_asteroids)
+int asteroid_cluster_add_some_random_asteroids(AsteroidCluster* all_asteroids, int total_asteroids, Rng* rng)
 {
-    while (total_asteroids>0) {
-        asteroid_cluster_add_a_random_asteroid(all_asteroids);
-        total_asteroids--;
+    AsteroidCluster* ac = all_asteroids;
+    if (total_asteroids <= 0) {
+        return 0;
+    }
+    int new_capacity = ac->capacity;
+    while (new_capacity < ac->count + total_asteroids) {
+        new_capacity *= 2;
+    }
+    if (new_capacity > ac->capacity) {
+        _asteroid_cluster_grow(ac, new_capacity);
     }
+    
+    // attribute by attribute, always in this order, so the same seed gives the same asteroids.
+    int first = ac->count;
+    rng_fill_float(rng, ac->x + first, total_asteroids, 1.0, (float)BUFFER_WIDTH);
+    rng_fill_float(rng, ac->y + first, total_asteroids, 1.0, (float)BUFFER_HEIGHT);
+    rng_fill_float(rng, ac->twist + first, total_asteroids, 0.0, 360.0);
+    rng_fill_float(rng, ac->rot_velocity + first, total_asteroids, 0.0, ASTEROID_MAX_ROT_SPEED);
+    rng_fill_float(rng, ac->scale + first, total_asteroids, ASTEROID_DEFAULT_SCALE_FACTOR_MIN, ASTEROID_DEFAULT_SCALE_FACTOR_MAX);
+    rng_fill_int(rng, ac->life_left + first, total_asteroids, 1, ASTEROID_BASE_LIFE);
+    // heading and speed go into vx, vy first, then turned into velocity in place.
+    rng_fill_float(rng, ac->vx + first, total_asteroids, 0.0, 360.0);
+    rng_fill_float(rng, ac->vy + first, total_asteroids, 0.0, ASTEROID_MAX_SPEED);
+    
+    for (int i = first; i < first + total_asteroids; i++) {
+        float heading = ac->vx[i];
+        float speed = ac->vy[i];
+        // 0 degree is north, screen y goes down, so it's -cos for y.
+        ac->vx[i] = speed * sinf(DEGTORAD(heading));
+        ac->vy[i] = -speed * cosf(DEGTORAD(heading));
+        // the twist drawn now is the one it got.
+        _asteroid_set_twist(ac, i, ac->twist[i]);
+        handle_table_add(&ac->handles, i);
+    }
+    ac->count += total_asteroids;
+    _asteroid_cluster_count_peak(ac);
     return 0;
 }
 
 
 
 // when hit, split to two.
-int asteroid_hit_and_split(AsteroidCluster* all_asteroids, Asteroid* asteroid)
+int asteroid_hit(AsteroidCluster* all_asteroids, Handle asteroid, CommandBuffer* commands, ParticlePool* particles)
 {
+    AsteroidCluster* ac = all_asteroids;
+    int index = handle_table_find(&ac->handles, asteroid);
+    if (index < 0) {
+        return -1;
+    }
     // once got hit, if not used all it's life, split; else, dispear.
-    if (asteroid->life_left) {  // life_left is int, minimum == 1.
-        // 1, Create a new asteroid, append it to its cluster.
+    if (ac->life_left[index]) {  // life_left is int, minimum == 1.
+        // turning heading by d degree is rotating the velocity vector by d, clockwise on screen.
+        float cos_d = ac->split_cos;
+        float sin_d = ac->split_sin;
+        float vx = ac->vx[index];
+        float vy = ac->vy[index];
+        
+        // 1, A new asteroid, appended to its cluster when the commands are applied.
         // change heading by -45 degree, hit time ++, scale half, others same,
-        Asteroid* new_asteroid = asteroid_create(
-                                                 asteroid->x,
-                                                 asteroid->y,
-                                                 asteroid->heading-ASTEROID_DEFAULT_SPLIT_DEGREE,
-                                                 asteroid->twist,
-                                                 asteroid->speed,
-                                                 asteroid->rot_velocity,
-                                                 asteroid->scale/ASTEROID_SCALE_FACTOR_WHEN_HIT,
-                                                 asteroid->life_left -1
-                                                 );
-        // add it to all ateroids.
-        asteroid_cluster_add_asteroid(all_asteroids, new_asteroid);
-        // 2, change current asteroid's direction and scale, and hit times.
-        asteroid->heading += ASTEROID_DEFAULT_SPLIT_DEGREE;
-        asteroid->scale = asteroid->scale / ASTEROID_SCALE_FACTOR_WHEN_HIT;
-        asteroid->life_left -= 1;
+        AsteroidSpawn child;
+        child.x = ac->x[index];
+        child.y = ac->y[index];
+        child.vx = vx * cos_d + vy * sin_d;
+        child.vy = vy * cos_d - vx * sin_d;
+        // the same twist as its parent, it spins the same way.
+        child.twist = ac->twist[index];
+        child.rot_velocity = ac->rot_velocity[index];
+        child.scale = ac->scale[index] / ASTEROID_SCALE_FACTOR_WHEN_HIT;
+        child.life_left = ac->life_left[index] - 1;
+        command_buffer_record_spawn(commands, &child, sizeof(AsteroidSpawn));
+        
+        // 2, change current asteroid's direction (+45 degree) and scale, and hit times. In place, nothing moves.
+        ac->vx[index] = vx * cos_d - vy * sin_d;
+        ac->vy[index] = vy * cos_d + vx * sin_d;
+        ac->scale[index] = ac->scale[index] / ASTEROID_SCALE_FACTOR_WHEN_HIT;
+        ac->life_left[index] -= 1;
     }
     else {
-        // destroy current asteroid.
-        asteroid_cluster_remove_asteroid_node(all_asteroids, asteroid->node_ref);
-        // Play VFX, added later.
+        // blow up where it was, it's removed when the commands are applied.
+        if (particles) {
+            particle_pool_burst(particles, ac->x[index], ac->y[index], PARTICLE_BURST);
+        }
+        command_buffer_record_remove(commands, asteroid);
+    }
+    return 0;
+}
+
+/*
+ Append the asteroid a spawn command holds.
+ */
+Handle _asteroid_cluster_spawn(AsteroidCluster* ac, AsteroidSpawn* spawn)
+{
+    if (ac->count == ac->capacity) {
+        _asteroid_cluster_grow(ac, ac->capacity * 2);
     }
+    int n = ac->count;
+    ac->x[n] = spawn->x;
+    ac->y[n] = spawn->y;
+    ac->vx[n] = spawn->vx;
+    ac->vy[n] = spawn->vy;
+    ac->twist[n] = spawn->twist;
+    ac->rot_velocity[n] = spawn->rot_velocity;
+    ac->scale[n] = spawn->scale;
+    ac->life_left[n] = spawn->life_left;
+    ac->count++;
+    _asteroid_cluster_count_peak(ac);
+    return handle_table_add(&ac->handles, n);
+}
+
+int asteroid_cluster_apply(AsteroidCluster* ac, CommandBuffer* commands)
+{
+    // one after another, each is O(1): swap-remove keeps the arrays packed, a spawn appends, nothing else moves.
+    for (int c = 0; c < commands->count; c++) {
+        Command* command = &commands->commands[c];
+        if (command->type == COMMAND_SPAWN) {
+            _asteroid_cluster_spawn(ac, command_buffer_spawn_data(commands, command));
+            commands->applied++;
+        }
+        else if (asteroid_cluster_remove_asteroid(ac, command->target) < 0) {
+            commands->stale++;
+        }
+        else {
+            commands->applied++;
+        }
+    }
+    command_buffer_clear(commands);
     return 0;
 }
 
 
-// update and draw all the asteroids, for surpress the warning of incompatible pointer type in function pointer parameters.
-int asteroid_update_wrapper(void* asteroid)
+// update and draw all the asteroids, walk the arrays from begin to end.
+typedef struct {
+    AsteroidCluster* ac;
+    float dt;
+} AsteroidUpdateTask;
+
+void _asteroid_cluster_update_range(void* context, int worker, int begin, int end)
 {
-    return asteroid_update((Asteroid*) asteroid);
+    AsteroidUpdateTask* task = context;
+    for (int i = begin; i < end; i++) {
+        asteroid_update(task->ac, i, task->dt);
+    }
 }
 
-int asteroid_draw_wrapper(void* asteroid)
+int asteroid_cluster_update(AsteroidCluster* ac, float dt, WorkerPool* workers)
 {
-    return asteroid_draw((Asteroid*) asteroid);
+    AsteroidUpdateTask task = { ac, dt };
+    // the twists all move on with it.
+    ac->spin_time += dt;
+    ac->last_dt = dt;
+    if (!workers) {
+        _asteroid_cluster_update_range(&task, 0, 0, ac->count);
+        return 0;
+    }
+    // every asteroid only touches its own elements, any split of them gives the same result.
+    worker_pool_run(workers, _asteroid_cluster_update_range, &task, ac->count, ASTEROID_PARALLEL_MIN);
+    return 0;
 }
 
-int asteroid_cluster_update(AsteroidCluster* ac)
+int asteroid_cluster_draw(AsteroidCluster* ac, float alpha, PrimBatch* batch)
 {
-    generic_cluster_iterate_and_do(ac, asteroid_update_wrapper, NULL);
+    for (int i = 0; i < ac->count; i++) {
+        asteroid_draw(ac, i, alpha, batch);
+    }
     return 0;
 }
 
-int asteroid_cluster_draw(AsteroidCluster* ac)
+int asteroid_cluster_print_stats(AsteroidCluster* ac)
 {
-    generic_cluster_iterate_and_do(ac, asteroid_draw_wrapper, NULL);
+    printf("asteroids: capacity %d, live %d, high-water %d, heap calls %ld, %d bytes an asteroid, %d hot (update and collision), %d cold (drawing and hits), handles %d live of %d slots, %ld stale finds\n",
+           ac->capacity, ac->count, ac->high_water, ac->heap_calls, ASTEROID_ARRAY_COUNT * 4, ASTEROID_HOT_ARRAY_COUNT * 4, (ASTEROID_ARRAY_COUNT - ASTEROID_HOT_ARRAY_COUNT) * 4,
+           ac->handles.live, ac->handles.slot_count, ac->handles.stale_finds);
     return 0;
 }
 
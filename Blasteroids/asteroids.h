@@ -13,74 +13,183 @@
 #include <allegro5/allegro_color.h>
 #include <allegro5/allegro_primitives.h>
 #include <math.h>
-#include "cluster.h"
 #include "spaceship.h"
 #include "blast.h"
 #include "common.h"
+#include "prim_batch.h"
+#include "worker_pool.h"
+#include "particles.h"
+#include "handle.h"
+#include "command_buffer.h"
+
+// points of the outline, a closed loop, so as many lines.
+#define ASTEROID_OUTLINE_POINTS 12
+// arrays in the arena, all of them are 4 bytes an asteroid.
+#define ASTEROID_ARRAY_COUNT 8
+// the first ones, what update and collision go through every tick, the rest are cold.
+#define ASTEROID_HOT_ARRAY_COUNT 5
+// an asteroid takes up a space of -25 to 20 in x, -20 to 20 in y, relative to it's x,y, rotation... for anoter day... its bounding box is a square of this, times its scale, either side of x,y.
+#define ASTEROID_BBOX_HALF 25
+// the arena starts on a cache line.
+#define ASTEROID_ARENA_ALIGN 64
 
 /*
- Cluster node of one asteroid.
+ Cluster of All the asteroids
+ 
+ Structure of arrays: each attribute of the asteroids is kept in its own contiguous array, the i-th asteroid is made of the i-th element of every array.
+ So update and collision only stream through the attributes they need, one after another in memory.
+ 
+ Asteroid is referred by its index. Removing one moves the last asteroid into its place (swap-remove), so the arrays stay packed, but an index is only good until the next remove.
+ Anything holding on to an asteroid across a remove holds its handle instead (handle.h), asteroid_cluster_find() gives where it is now, or -1 once it's gone. Removing goes by handle too.
+ 
+ Velocity is kept as vx, vy (px/second) instead of heading and speed, that's what update needs every tick. A split turns the velocity vector instead.
+ 
+ Hot and cold: update and collision only go through position, velocity and scale, 20 bytes an asteroid, the hot arrays.
+ The bounding box is not kept, it's x, y plus or minus ASTEROID_BBOX_HALF * scale, the grid and the sweep work it out when they're filled, it's less to stream than 16 more bytes.
+ The rest is cold, only drawing or a hit reads it:
+    twist  -- it's the twist at spin_time 0 (phase), drawing works out the twist from it, rot_velocity and spin_time. Nothing in the sim depends on it, so update never touches it.
+    where it was last step -- not kept, it's x, y - velocity * last_dt, the screen wraps so drawing takes the short way.
+ The color is the same for all, it's the cluster's.
+ 
+ All the arrays live in one block of memory, the arena, one after another, capacity elements each, the hot ones first. So growing, saving or loading the cluster is one big copy per array, never per asteroid.
  */
-typedef GenericClusterNode AsteroidClusterNode;
+typedef struct {
+    void* arena;    // all the arrays below point into it.
+    // hot
+    float* x;
+    float* y;
+    float* vx;  // in px/second
+    float* vy;  // in px/second, screen y goes down.
+    float* scale;
+    // cold
+    float* twist;    // in degree, 0-360, at spin_time 0.
+    float* rot_velocity; // in degree, per 1/GAME_FPS tick.
+    int* life_left;
+    int count;      // asteroids in the cluster, 0 == all clear.
+    int capacity;   // room of each array, grows when full.
+    double spin_time;   // in seconds, sim time the twists are worked out at.
+    float last_dt;      // of the last update, drawing interpolates back over it.
+    int high_water;     // the most asteroids at once.
+    long heap_calls;    // times the arena was allocated, it only grows, once it's big enough for the peak there's no more.
+    ALLEGRO_COLOR color;    // all the asteroids look the same.
+    HandleTable handles;    // cold, by index like the arrays, only add, remove and find go through it.
+    float split_cos, split_sin;     // of ASTEROID_DEFAULT_SPLIT_DEGREE, so split doesn't need trig.
+    // the outline in asteroid's own space (scale 1, twist 0), each line already expanded to a quad of its thickness, 4 corners per line. Drawing only transforms the corners.
+    float outline_quads[ASTEROID_OUTLINE_POINTS * 4][2];
+} AsteroidCluster;
 
 /*
- Cluster of All the asteroids
- 
- Using generic cluster.
+ public functions
  */
 
-typedef GenerictCluster AsteroidCluster;
+/*
+ init an empty asteroid cluster.
+ */
+int asteroid_cluster_init(AsteroidCluster* ac);
 
 /*
- Individual asteroid.
+ Free the arrays and the cluster itself, like the other xxx_destroy() (spaceship, score, level): the caller mallocs it, destroy frees it.
+ The linked-list cluster this replaced only freed its nodes, the caller had to free the cluster, so don't free it again after this.
  */
+int asteroid_cluster_destroy(AsteroidCluster* ac);
 
-typedef struct {
-    float x;
-    float y;
-    float heading;   // in degree, 0-360
-    float twist;    // in degree, 0-360
-    float speed;    // in px/second
-    float rot_velocity; // in degree, 0-360/second
-    float scale;
-    int life_left;
-    ALLEGRO_COLOR color;
-    AsteroidClusterNode* node_ref; // holds the ref to the data-structural counterpart object. so each asteroid will have information about clusters, makes remove and add easier.
-} Asteroid;
+/*
+ add an asteroid at the end, return its handle.
+ */
+Handle asteroid_cluster_add_asteroid(AsteroidCluster* ac,
+                                  float x,
+                                  float y,
+                                  float heading,   // in degree, 0-360
+                                  float twist,    // in degree, 0-360
+                                  float speed,    // in px/second
+                                  float rot_velocity, // in degree, per 1/GAME_FPS tick
+                                  float scale,
+                                  int life_left);
 
 /*
- public functions
+ Size in bytes of the asteroids packed by asteroid_cluster_pack(), it's count * ASTEROID_ARRAY_COUNT * 4, then the handle table. spin_time and last_dt are not in it.
  */
+size_t asteroid_cluster_packed_size(AsteroidCluster* ac);
 
 /*
- init an empty asteroid cluster.
+ Copy every asteroid into dst, the part in use of each array, one after another, then the handle table. dst has to hold asteroid_cluster_packed_size() bytes.
  */
-int asteroid_cluster_init(AsteroidCluster* ac);
+int asteroid_cluster_pack(AsteroidCluster* ac, void* dst);
 
-int asteroid_cluster_destroy(AsteroidCluster* ac);
+/*
+ Replace every asteroid with the count ones packed in src by asteroid_cluster_pack().
+ The handles are as they were when packed: hit resolve goes by handle, a restored game has to give out the same ones to play out the same.
+ */
+int asteroid_cluster_unpack(AsteroidCluster* ac, const void* src, int count);
 
 /*
- add a random asteroid
+ Handle of the asteroid at index.
  */
-int asteroid_cluster_add_a_random_asteroid(AsteroidCluster* all_asteroids);
+Handle asteroid_cluster_handle(AsteroidCluster* ac, int index);
 
-int asteroid_cluster_add_some_random_asteroids(AsteroidCluster* all_asteroids, int total_asteroids);
+/*
+ Index of the asteroid now, -1 if it's gone.
+ */
+int asteroid_cluster_find(AsteroidCluster* ac, Handle asteroid);
+
+/*
+ remove the asteroid, the last asteroid takes its index. Return -1 if it was gone already.
+ */
+int asteroid_cluster_remove_asteroid(AsteroidCluster* ac, Handle asteroid);
+
+/*
+ add a random asteroid, the same as asteroid_cluster_add_some_random_asteroids() of 1, it draws from rng in the same order.
+ */
+int asteroid_cluster_add_a_random_asteroid(AsteroidCluster* all_asteroids, Rng* rng);
+
+/*
+ add total_asteroids random ones at once, each attribute is batch filled from rng straight into its array.
+ */
+int asteroid_cluster_add_some_random_asteroids(AsteroidCluster* all_asteroids, int total_asteroids, Rng* rng);
+
+/*
+ A split one, as recorded by asteroid_hit(), for a spawn command.
+ */
+typedef struct {
+    float x, y;
+    float vx, vy;
+    float twist;
+    float rot_velocity;
+    float scale;
+    int life_left;
+} AsteroidSpawn;
 
 /*
  when an asteroid hit and split
+ 
+ It doesn't spawn or remove anything now, it's recorded into commands, for asteroid_cluster_apply(): with life left, it turns and halves in place, the split one is a spawn. Out of life, it's a remove, and it blows up into particles (could be NULL, no explosion) right away.
+ Return -1 if it was gone already, nothing happens.
+ */
+int asteroid_hit(AsteroidCluster* all_asteroids, Handle asteroid, CommandBuffer* commands, ParticlePool* particles);
+
+/*
+ Apply every command recorded in commands (command_buffer.h), in the order recorded, then empty it: remove takes the asteroid out (the last one takes its index), spawn appends an AsteroidSpawn.
  */
-int asteroid_hit_and_split(AsteroidCluster* all_asteroids, Asteroid* asteroid);
+int asteroid_cluster_apply(AsteroidCluster* ac, CommandBuffer* commands);
+
 
+/*
+ update all asteroids in the cluster towards next moment, dt seconds later.
+ 
+ With ASTEROID_PARALLEL_MIN asteroids or more, they are split across the workers, returns when all are done. workers could be NULL, then it's serial.
+ */
+int asteroid_cluster_update(AsteroidCluster* ac, float dt, WorkerPool* workers);
 
 /*
- update all asteroids in the cluster towards next moment.
+ draw all the asteroids in the cluster, at alpha (0-1) of the way from the previous sim step to the current one.
+ They are only added to batch, caller flushes it.
  */
-int asteroid_cluster_update(AsteroidCluster* ac);
+int asteroid_cluster_draw(AsteroidCluster* ac, float alpha, PrimBatch* batch);
 
 /*
- draw all the asteroids in the cluster.
+ Capacity, and bytes an asteroid, hot and cold.
  */
-int asteroid_cluster_draw(AsteroidCluster* ac);
+int asteroid_cluster_print_stats(AsteroidCluster* ac);
 
 
 
@@ -0,0 +1,89 @@
+//
+//  aabb_bench.c
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/01.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+/*
+ Microbenchmark of the batch bounding box kernels (aabb_batch.h).
+ 
+ For 1k, 10k and 100k boxes, run the same queries through every kernel the cpu supports, check the masks are bit-identical to the scalar one, and print ns per box.
+ 
+ Build, from the Blasteroids folder:
+    cc -O2 -I. -o aabb_bench bench/aabb_bench.c aabb_batch.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "aabb_batch.h"
+
+#define BENCH_QUERIES 200
+
+double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+float random_float(float lo, float hi)
+{
+    return lo + ((float)rand() / (float)RAND_MAX) * (hi - lo);
+}
+
+int main(int argc, char **argv)
+{
+    int box_counts[] = { 1000, 10000, 100000 };
+    AabbKernel kernels[] = { AABB_KERNEL_SCALAR, AABB_KERNEL_SSE2, AABB_KERNEL_AVX2 };
+    srand(1);
+    
+    printf("boxes,kernel,ns_per_box,hits,identical\n");
+    for (int b = 0; b < 3; b++) {
+        int count = box_counts[b];
+        float* min_x = malloc(count * sizeof(float));
+        float* min_y = malloc(count * sizeof(float));
+        float* max_x = malloc(count * sizeof(float));
+        float* max_y = malloc(count * sizeof(float));
+        for (int i = 0; i < count; i++) {
+            // asteroid sized boxes all over the screen.
+            float x = random_float(0, 1280), y = random_float(0, 960), half = random_float(12.5, 75);
+            min_x[i] = x - half;
+            min_y[i] = y - half;
+            max_x[i] = x + half;
+            max_y[i] = y + half;
+        }
+        int words = (count + 31) / 32;
+        uint32_t* reference = malloc(words * BENCH_QUERIES * sizeof(uint32_t));
+        uint32_t* masks = malloc(words * BENCH_QUERIES * sizeof(uint32_t));
+        
+        for (int k = 0; k < 3; k++) {
+            // skip the ones this cpu can't run, select falls back to something else.
+            if (aabb_batch_select(kernels[k]) != kernels[k]) {
+                continue;
+            }
+            uint32_t* out = (k == 0) ? reference : masks;
+            long hits = 0;
+            srand(2);
+            double begin = now_ns();
+            for (int q = 0; q < BENCH_QUERIES; q++) {
+                // blast sized query boxes.
+                float x = random_float(0, 1280), y = random_float(0, 960);
+                hits += aabb_batch_overlap(min_x, min_y, max_x, max_y, count, x - 5, y - 5, x + 5, y + 5, out + q * words);
+            }
+            double elapsed = now_ns() - begin;
+            int identical = (k == 0) || memcmp(reference, masks, words * BENCH_QUERIES * sizeof(uint32_t)) == 0;
+            printf("%d,%s,%.3f,%ld,%s\n", count, aabb_batch_kernel_name(), elapsed / ((double)count * BENCH_QUERIES), hits, identical ? "yes" : "NO");
+        }
+        free(min_x);
+        free(min_y);
+        free(max_x);
+        free(max_y);
+        free(reference);
+        free(masks);
+    }
+    return 0;
+}
@@ -0,0 +1,273 @@
+//
+//  blasteroids_bench.c
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/08.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+/*
+ Headless stress benchmark of the whole game, the baseline every storage and collision change is measured against.
+
+ A GAME_INSTANCE is built without any display, then scripted scenarios run for BENCH_TICKS sim steps each:
+    drift   -- N asteroids flying around, no blasts.
+    fire    -- N asteroids, BENCH_FIRE_RATE blasts fired every tick from all over the screen, every asteroid at full life so every hit splits.
+               It fires past the weapon's cooldown, into a ring of BENCH_BLAST_CAPACITY, so none of them is recycled.
+    blasts  -- no asteroids, the same fire, so the blasts fly their whole lifetime or off the screen. In a field of asteroids most are hit the tick they're fired, before blast update gets to them, this is the row blast update is measured by.
+ N goes from 100 to 100k, blasts is one row of 0.
+ 
+ Bytes an entity goes with every row: asteroid_bytes (all its arrays) and asteroid_hot_bytes (what update and collision stream through every tick), blast_bytes and blast_hot_bytes the same for a blast.
+ The fewer hot bytes, the fewer cache lines a tick pulls in, at 50k asteroids and up the arrays are far bigger than the cache.
+
+ Each stage of a tick is timed on its own, and reported as ns per entity it went through:
+    asteroid_update -- per asteroid.
+    blast_update    -- per blast.
+    ship_crash      -- per asteroid.
+    hit_detection   -- per asteroid + blast.
+    draw_list       -- per asteroid + blast, filling the batch, not drawing it.
+    particle_update -- per live particle, the explosions of the asteroids destroyed.
+    particle_draw   -- per live particle, filling the batch.
+ A stage that had nothing to go through is n/a (null in JSON).
+ The particle stages are also given as particles per ms, the budget (PARTICLE_BUDGET) is what a frame has to go through at worst.
+
+ Output is CSV, or JSON with --json. --threads=N splits the asteroid update across N threads.
+
+ Build, from the Blasteroids folder:
+    cc -O2 -I. -o blasteroids_bench bench/blasteroids_bench.c $(ls *.c | grep -v blasteroid.c) -lm -pthread $(pkg-config --libs allegro-5 allegro_font-5 allegro_primitives-5)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "game.h"
+#include "prim_batch.h"
+#include "renderer.h"
+
+#define BENCH_TICKS 200
+#define BENCH_FIRE_RATE 8
+// every blast fired in BLAST_LIFETIME at BENCH_FIRE_RATE a tick fits.
+#define BENCH_BLAST_CAPACITY 1024
+#define BENCH_SEED 1
+
+typedef enum {
+    SCENARIO_DRIFT,
+    SCENARIO_FIRE,
+    SCENARIO_BLASTS,
+    SCENARIO_COUNT
+} Scenario;
+
+typedef enum {
+    STAGE_ASTEROID_UPDATE,
+    STAGE_BLAST_UPDATE,
+    STAGE_SHIP_CRASH,
+    STAGE_HIT_DETECTION,
+    STAGE_DRAW_LIST,
+    STAGE_PARTICLE_UPDATE,
+    STAGE_PARTICLE_DRAW,
+    STAGE_COUNT
+} Stage;
+
+const char* stage_names[STAGE_COUNT] = { "asteroid_update", "blast_update", "ship_crash", "hit_detection", "draw_list", "particle_update", "particle_draw" };
+
+typedef struct {
+    double ns[STAGE_COUNT];
+    double entities[STAGE_COUNT];   // summed over the ticks.
+    int final_asteroids;
+    long blasts_fired;
+    long particles_spawned;
+} BenchResult;
+
+double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+ One scenario: the same stages game_step() and draw_everything() go through, in the same order, each one timed.
+ */
+BenchResult run_scenario(int asteroid_count, int fire_rate, int threads, Renderer* renderer, PrimBatch* batch)
+{
+    BenchResult result;
+    memset(&result, 0, sizeof(result));
+    float dt = 1.0 / DEFAULT_SIM_HZ;
+
+    GAME_INSTANCE* game = malloc(sizeof(GAME_INSTANCE));
+    game_instance_init(game, BENCH_SEED, threads, WEAPON_COOLDOWN, BLAST_LIFETIME);
+    blastcluster_destroy(game->all_blasts);
+    game->all_blasts = malloc(sizeof(BlastCluster));
+    blastcluster_init(game->all_blasts, BENCH_BLAST_CAPACITY);
+    AsteroidCluster* ac = game->all_asteroids;
+    if (asteroid_count > ac->count) {
+        asteroid_cluster_add_some_random_asteroids(ac, asteroid_count - ac->count, game->rng);
+    }
+    // none at all, not even level 1's.
+    while (asteroid_count == 0 && ac->count > 0) {
+        asteroid_cluster_remove_asteroid(ac, asteroid_cluster_handle(ac, 0));
+    }
+    if (fire_rate) {
+        // full life, so every hit splits instead of just removing it.
+        for (int i = 0; i < ac->count; i++) {
+            ac->life_left[i] = ASTEROID_BASE_LIFE;
+        }
+    }
+
+    for (int tick = 0; tick < BENCH_TICKS; tick++) {
+        spaceship_keep_previous(game->ship);
+        // the gun jumps around the screen, so blasts go everywhere, not just from the center.
+        for (int f = 0; f < fire_rate; f++) {
+            game->ship->x = random_between_f(game->rng, 0, BUFFER_WIDTH);
+            game->ship->y = random_between_f(game->rng, 0, BUFFER_HEIGHT);
+            spaceship_turn_left(game->ship, dt);
+            blastcluster_add_blast(game->all_blasts, game->ship, BLAST_LIFETIME);
+        }
+        result.blasts_fired += fire_rate;
+        int asteroids = ac->count;
+        int blasts = game->all_blasts->count;
+
+        double start = now_ns();
+        if (ship_crash_detection(ac, game->ship, game->sweep)) {
+            spaceship_just_hit(game->ship);
+        }
+        result.ns[STAGE_SHIP_CRASH] += now_ns() - start;
+        result.entities[STAGE_SHIP_CRASH] += asteroids;
+
+        start = now_ns();
+        game->score->score += asteroid_hit_detection(ac, game->all_blasts, game->grid, game->hits, game->workers, &game->blast_commands, &game->asteroid_commands, game->particles);
+        blastcluster_apply(game->all_blasts, &game->blast_commands);
+        asteroid_cluster_apply(ac, &game->asteroid_commands);
+        result.ns[STAGE_HIT_DETECTION] += now_ns() - start;
+        result.entities[STAGE_HIT_DETECTION] += asteroids + blasts;
+
+        blasts = game->all_blasts->count;
+        start = now_ns();
+        blastcluster_update(game->all_blasts, dt, &game->blast_commands);
+        blastcluster_apply(game->all_blasts, &game->blast_commands);
+        result.ns[STAGE_BLAST_UPDATE] += now_ns() - start;
+        result.entities[STAGE_BLAST_UPDATE] += blasts;
+
+        asteroids = ac->count;
+        start = now_ns();
+        asteroid_cluster_update(ac, dt, game->workers);
+        result.ns[STAGE_ASTEROID_UPDATE] += now_ns() - start;
+        result.entities[STAGE_ASTEROID_UPDATE] += asteroids;
+
+        int particles = game->particles->count;
+        start = now_ns();
+        particle_pool_update(game->particles, dt);
+        result.ns[STAGE_PARTICLE_UPDATE] += now_ns() - start;
+        result.entities[STAGE_PARTICLE_UPDATE] += particles;
+
+        spaceship_update(game->ship, dt);
+
+        blasts = game->all_blasts->count;
+        start = now_ns();
+        blastcluster_draw(game->all_blasts, 1.0, batch);
+        asteroid_cluster_draw(ac, 1.0, batch);
+        result.ns[STAGE_DRAW_LIST] += now_ns() - start;
+        result.entities[STAGE_DRAW_LIST] += asteroids + blasts;
+
+        particles = game->particles->count;
+        start = now_ns();
+        particle_pool_draw(game->particles, 1.0, batch);
+        result.ns[STAGE_PARTICLE_DRAW] += now_ns() - start;
+        result.entities[STAGE_PARTICLE_DRAW] += particles;
+        // not timed, the null renderer only empties it.
+        prim_batch_flush(batch, renderer);
+    }
+    result.final_asteroids = ac->count;
+    result.particles_spawned = game->particles->spawned;
+    game_instance_destroy(game);
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    bool json = false;
+    int threads = DEFAULT_THREADS;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        }
+        else if (strncmp(argv[i], "--threads=", 10) == 0) {
+            threads = atoi(argv[i] + 10);
+        }
+    }
+    int asteroid_counts[] = { 100, 1000, 10000, 50000, 100000 };
+    int asteroid_count_n = sizeof(asteroid_counts) / sizeof(asteroid_counts[0]);
+    int asteroid_bytes = ASTEROID_ARRAY_COUNT * 4;
+    int asteroid_hot_bytes = ASTEROID_HOT_ARRAY_COUNT * 4;
+    int blast_hot_bytes = sizeof(Blast);
+    int blast_bytes = blast_hot_bytes + sizeof(float) + sizeof(unsigned char);    // and the cold life_left and color.
+    const char* scenario_names[SCENARIO_COUNT] = { "drift", "fire", "blasts" };
+    int fire_rates[SCENARIO_COUNT] = { 0, BENCH_FIRE_RATE, BENCH_FIRE_RATE };
+    must_init(al_init(), "allegro");
+    Renderer* renderer = malloc(sizeof(Renderer));
+    renderer_init_null(renderer);
+    PrimBatch* batch = malloc(sizeof(PrimBatch));
+    prim_batch_init(batch);
+
+    if (json) {
+        printf("[\n");
+    }
+    else {
+        printf("scenario,asteroids,ticks,blasts_fired,final_asteroids,particles_spawned,asteroid_bytes,asteroid_hot_bytes,blast_bytes,blast_hot_bytes");
+        for (int s = 0; s < STAGE_COUNT; s++) {
+            printf(",%s_ns", stage_names[s]);
+        }
+        printf(",particle_update_per_ms,particle_draw_per_ms\n");
+    }
+    for (int sc = 0; sc < SCENARIO_COUNT; sc++) {
+        // blasts is one row, no asteroids.
+        int rows = sc == SCENARIO_BLASTS ? 1 : asteroid_count_n;
+        for (int a = 0; a < rows; a++) {
+            int asteroid_count = sc == SCENARIO_BLASTS ? 0 : asteroid_counts[a];
+            BenchResult result = run_scenario(asteroid_count, fire_rates[sc], threads, renderer, batch);
+            if (json) {
+                printf("  {\"scenario\": \"%s\", \"asteroids\": %d, \"ticks\": %d, \"blasts_fired\": %ld, \"final_asteroids\": %d, \"particles_spawned\": %ld, \"asteroid_bytes\": %d, \"asteroid_hot_bytes\": %d, \"blast_bytes\": %d, \"blast_hot_bytes\": %d",
+                       scenario_names[sc], asteroid_count, BENCH_TICKS, result.blasts_fired, result.final_asteroids, result.particles_spawned, asteroid_bytes, asteroid_hot_bytes, blast_bytes, blast_hot_bytes);
+            }
+            else {
+                printf("%s,%d,%d,%ld,%d,%ld,%d,%d,%d,%d", scenario_names[sc], asteroid_count, BENCH_TICKS, result.blasts_fired, result.final_asteroids, result.particles_spawned,
+                       asteroid_bytes, asteroid_hot_bytes, blast_bytes, blast_hot_bytes);
+            }
+            for (int s = 0; s < STAGE_COUNT; s++) {
+                // ns per entity, n/a if the stage had nothing to go through.
+                if (result.entities[s] == 0) {
+                    if (json) {
+                        printf(", \"%s_ns\": null", stage_names[s]);
+                    }
+                    else {
+                        printf(",n/a");
+                    }
+                    continue;
+                }
+                double per_entity = result.ns[s] / result.entities[s];
+                if (json) {
+                    printf(", \"%s_ns\": %.2f", stage_names[s], per_entity);
+                }
+                else {
+                    printf(",%.2f", per_entity);
+                }
+            }
+            // particles a ms, 0 if there were none.
+            double update_per_ms = result.ns[STAGE_PARTICLE_UPDATE] > 0 ? result.entities[STAGE_PARTICLE_UPDATE] / result.ns[STAGE_PARTICLE_UPDATE] * 1e6 : 0;
+            double draw_per_ms = result.ns[STAGE_PARTICLE_DRAW] > 0 ? result.entities[STAGE_PARTICLE_DRAW] / result.ns[STAGE_PARTICLE_DRAW] * 1e6 : 0;
+            if (json) {
+                printf(", \"particle_update_per_ms\": %.0f, \"particle_draw_per_ms\": %.0f}%s\n", update_per_ms, draw_per_ms, sc == SCENARIO_COUNT - 1 && a == rows - 1 ? "" : ",");
+            }
+            else {
+                printf(",%.0f,%.0f\n", update_per_ms, draw_per_ms);
+            }
+        }
+    }
+    if (json) {
+        printf("]\n");
+    }
+
+    prim_batch_destroy(batch);
+    renderer_destroy(renderer);
+    return 0;
+}
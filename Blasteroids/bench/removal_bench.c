@@ -0,0 +1,273 @@
+//
+//  removal_bench.c
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/11.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+/*
+ Benchmark and check of deferred removal (command_buffer.h), removing every Nth entity of a big cluster.
+
+ Scenarios, each for N of 1 (all of them), 2, 3, 10 and 100:
+    remove -- N-th asteroids of 10k and 100k get a remove command, recorded while going through the whole cluster.
+    hit    -- the same with asteroid_hit(), so some split (a spawn) and the ones out of life blow up (a remove).
+    blast  -- N-th blasts of a full ring of BENCH_BLAST_CAPACITY, the first time with its head somewhere in the middle.
+ The commands are applied BENCH_REPEATS times from the same start, apply is timed, in ns per command.
+
+ Then the result is checked, ok is yes only if all of it holds:
+    count is what it should be.
+    every removed (or blown up) one's handle finds nothing.
+    every other one's handle finds it, the same x, y it started with, a split one at half scale with a life less. Blasts also still in the order they were fired.
+    the ones that aren't any of those are the split children, one for each split, each where its parent was, at its parent's new scale and life.
+ It exits with 1 if any row isn't ok, so it's a check as well as a benchmark.
+
+ Build, from the Blasteroids folder:
+    cc -O2 -I. -o removal_bench bench/removal_bench.c $(ls *.c | grep -v blasteroid.c) -lm -pthread $(pkg-config --libs allegro-5 allegro_font-5 allegro_primitives-5)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "asteroids.h"
+#include "blast.h"
+#include "command_buffer.h"
+
+#define BENCH_REPEATS 20
+#define BENCH_SEED 1
+#define BENCH_BLAST_CAPACITY 1024
+// fired past capacity, so the ring has wrapped.
+#define BENCH_BLAST_OVERFLOW 300
+
+/*
+ A split child, what it should be or what it is, to compare them sorted.
+ */
+typedef struct {
+    float x, y;
+    float scale;
+    int life_left;
+} ChildCheck;
+
+int child_check_compare(const void* a, const void* b)
+{
+    const ChildCheck* ca = a;
+    const ChildCheck* cb = b;
+    if (ca->x != cb->x) {
+        return ca->x < cb->x ? -1 : 1;
+    }
+    if (ca->y != cb->y) {
+        return ca->y < cb->y ? -1 : 1;
+    }
+    if (ca->scale != cb->scale) {
+        return ca->scale < cb->scale ? -1 : 1;
+    }
+    return ca->life_left - cb->life_left;
+}
+
+double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+ hit or remove every every-th asteroid of count ones, print the row, return 1 if it checked ok.
+ */
+int bench_asteroids(int hit, int count, int every, const char* name)
+{
+    Rng rng;
+    rng_seed(&rng, BENCH_SEED);
+    AsteroidCluster* ac = malloc(sizeof(AsteroidCluster));
+    asteroid_cluster_init(ac);
+    asteroid_cluster_add_some_random_asteroids(ac, count, &rng);
+    // a quarter on their last life, so a hit blows those up instead of splitting.
+    for (int i = 0; i < count; i += 4) {
+        ac->life_left[i] = 0;
+    }
+    void* start = malloc(asteroid_cluster_packed_size(ac));
+    asteroid_cluster_pack(ac, start);
+    float* x = malloc(count * sizeof(float));
+    float* y = malloc(count * sizeof(float));
+    float* scale = malloc(count * sizeof(float));
+    int* life_left = malloc(count * sizeof(int));
+    memcpy(x, ac->x, count * sizeof(float));
+    memcpy(y, ac->y, count * sizeof(float));
+    memcpy(scale, ac->scale, count * sizeof(float));
+    memcpy(life_left, ac->life_left, count * sizeof(int));
+    Handle* handles = malloc(count * sizeof(Handle));
+    CommandBuffer commands;
+    command_buffer_init(&commands);
+
+    double total = 0;
+    int recorded = 0;
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        asteroid_cluster_unpack(ac, start, count);
+        recorded = 0;
+        // going through all of them, nothing moves while it goes.
+        for (int i = 0; i < ac->count; i++) {
+            handles[i] = asteroid_cluster_handle(ac, i);
+            if (i % every == 0) {
+                if (hit) {
+                    asteroid_hit(ac, handles[i], &commands, NULL);
+                }
+                else {
+                    command_buffer_record_remove(&commands, handles[i]);
+                }
+            }
+        }
+        recorded = commands.count;
+        double t = now_ns();
+        asteroid_cluster_apply(ac, &commands);
+        total += now_ns() - t;
+    }
+
+    // what it should be: a remove, or a hit out of life, is gone, a hit with life left splits in two.
+    int expected = count;
+    int ok = 1;
+    unsigned char* original = calloc(ac->count, sizeof(unsigned char));
+    ChildCheck* expected_children = malloc(count * sizeof(ChildCheck));
+    ChildCheck* children = malloc(ac->count * sizeof(ChildCheck));
+    int expected_child_count = 0;
+    for (int i = 0; i < count; i++) {
+        int targeted = i % every == 0;
+        int gone = targeted && (!hit || life_left[i] == 0);
+        int split = targeted && !gone;
+        if (targeted) {
+            expected += gone ? -1 : 1;
+        }
+        int found = asteroid_cluster_find(ac, handles[i]);
+        if (gone) {
+            ok &= found == -1;
+            continue;
+        }
+        if (found < 0 || found >= ac->count) {
+            ok = 0;
+            continue;
+        }
+        original[found] = 1;
+        ok &= ac->x[found] == x[i] && ac->y[found] == y[i];
+        if (split) {
+            ChildCheck child = { x[i], y[i], scale[i] / ASTEROID_SCALE_FACTOR_WHEN_HIT, life_left[i] - 1 };
+            ok &= ac->scale[found] == child.scale && ac->life_left[found] == child.life_left;
+            expected_children[expected_child_count++] = child;
+        }
+        else {
+            ok &= ac->scale[found] == scale[i] && ac->life_left[found] == life_left[i];
+        }
+    }
+    ok &= ac->count == expected && ac->handles.live == ac->count && commands.count == 0;
+    // the rest are the children.
+    int child_count = 0;
+    for (int j = 0; j < ac->count; j++) {
+        if (!original[j]) {
+            ChildCheck child = { ac->x[j], ac->y[j], ac->scale[j], ac->life_left[j] };
+            children[child_count++] = child;
+        }
+    }
+    ok &= child_count == expected_child_count;
+    if (child_count == expected_child_count) {
+        qsort(children, child_count, sizeof(ChildCheck), child_check_compare);
+        qsort(expected_children, expected_child_count, sizeof(ChildCheck), child_check_compare);
+        for (int c = 0; c < child_count; c++) {
+            ok &= child_check_compare(&children[c], &expected_children[c]) == 0;
+        }
+    }
+
+    printf("%s,%d,%d,%d,%.2f,%d,%s\n", name, count, every, recorded, total / BENCH_REPEATS / recorded, ac->count, ok ? "yes" : "NO");
+    command_buffer_release(&commands);
+    free(children);
+    free(expected_children);
+    free(original);
+    free(handles);
+    free(life_left);
+    free(scale);
+    free(y);
+    free(x);
+    free(start);
+    asteroid_cluster_destroy(ac);
+    return ok;
+}
+
+int bench_blasts(int every)
+{
+    BlastCluster* bc = malloc(sizeof(BlastCluster));
+    blastcluster_init(bc, BENCH_BLAST_CAPACITY);
+    Spaceship ship;
+    spaceship_init(&ship, 0, BUFFER_HEIGHT / 2);
+    // each blast fired from its own x, so x tells which one it is.
+    for (int i = 0; i < BENCH_BLAST_CAPACITY + BENCH_BLAST_OVERFLOW; i++) {
+        ship.x = i;
+        blastcluster_add_blast(bc, &ship, BLAST_LIFETIME);
+    }
+    int count = bc->count;
+    void* start = malloc(blastcluster_packed_size(bc));
+    blastcluster_pack(bc, start);
+    Handle* handles = malloc(count * sizeof(Handle));
+    CommandBuffer commands;
+    command_buffer_init(&commands);
+
+    double total = 0;
+    int recorded = 0;
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        // the ring as fired the first time, then as unpacked, head at 0.
+        if (r > 0) {
+            blastcluster_unpack(bc, start, count);
+        }
+        recorded = 0;
+        for (int k = 0; k < bc->count; k++) {
+            handles[k] = blastcluster_handle(bc, k);
+            if (k % every == 0) {
+                command_buffer_record_remove(&commands, handles[k]);
+                recorded++;
+            }
+        }
+        double t = now_ns();
+        blastcluster_apply(bc, &commands);
+        total += now_ns() - t;
+    }
+
+    int ok = 1;
+    int kept = 0;
+    float last_x = -1;
+    for (int k = 0; k < count; k++) {
+        int found = blastcluster_find(bc, handles[k]);
+        if (k % every == 0) {
+            ok &= found == -1;
+            continue;
+        }
+        // still in the order fired.
+        if (found != kept) {
+            ok = 0;
+            break;
+        }
+        ok &= blastcluster_at(bc, found)->x > last_x;
+        last_x = blastcluster_at(bc, found)->x;
+        kept++;
+    }
+    ok &= bc->count == kept && bc->handles.live == kept;
+
+    printf("blast,%d,%d,%d,%.2f,%d,%s\n", count, every, recorded, total / BENCH_REPEATS / recorded, bc->count, ok ? "yes" : "NO");
+    command_buffer_release(&commands);
+    free(handles);
+    free(start);
+    blastcluster_destroy(bc);
+    return ok;
+}
+
+int main(void)
+{
+    int asteroid_counts[] = { 10000, 100000 };
+    int every[] = { 1, 2, 3, 10, 100 };
+    int all_ok = 1;
+    printf("scenario,entities,every,commands,apply_ns_per_command,count_after,ok\n");
+    for (int e = 0; e < 5; e++) {
+        for (int a = 0; a < 2; a++) {
+            all_ok &= bench_asteroids(0, asteroid_counts[a], every[e], "remove");
+            all_ok &= bench_asteroids(1, asteroid_counts[a], every[e], "hit");
+        }
+        all_ok &= bench_blasts(every[e]);
+    }
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+//
+//  snapshot_bench.c
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/07.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+/*
+ Microbenchmark of the whole-world snapshot (snapshot.h).
+
+ For 1k, 10k and 50k asteroids with the blast ring full, time snapshot_save() and snapshot_restore() in us.
+ Then check rollback is exact: save, run some steps, restore, run the same steps again, both runs must end in byte-identical snapshots.
+
+ Build, from the Blasteroids folder:
+    cc -O2 -I. -o snapshot_bench bench/snapshot_bench.c $(ls *.c | grep -v blasteroid.c) -lm -pthread $(pkg-config --libs allegro-5 allegro_font-5 allegro_primitives-5)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "game.h"
+#include "snapshot.h"
+
+#define BENCH_REPEATS 200
+// more than BLAST_CAPACITY, the ring ends up full.
+#define BENCH_BLASTS 64
+#define BENCH_ROLLBACK_STEPS 120
+
+double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+ Run steps sim steps, the ship keeps turning and firing, so blasts come and go and asteroids get hit.
+ */
+void run_steps(GAME_INSTANCE* game, int steps, float dt)
+{
+    for (int i = 0; i < steps; i++) {
+        game_step(game, INPUT_LEFT | INPUT_FIRE, dt);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int asteroid_counts[] = { 1000, 10000, 50000 };
+    float dt = 1.0 / DEFAULT_SIM_HZ;
+    must_init(al_init(), "allegro");
+
+    printf("asteroids,blasts,bytes,save_us,restore_us,identical\n");
+    for (int a = 0; a < 3; a++) {
+        GAME_INSTANCE* game = malloc(sizeof(GAME_INSTANCE));
+        game_instance_init(game, 1, DEFAULT_THREADS, WEAPON_COOLDOWN, BLAST_LIFETIME);
+        asteroid_cluster_add_some_random_asteroids(game->all_asteroids, asteroid_counts[a] - game->all_asteroids->count, game->rng);
+        for (int i = 0; i < BENCH_BLASTS; i++) {
+            blastcluster_add_blast(game->all_blasts, game->ship, BLAST_LIFETIME);
+        }
+        int blasts = game->all_blasts->count;
+
+        Snapshot* snapshot = malloc(sizeof(Snapshot));
+        snapshot_init(snapshot);
+        // once before timing, so the buffer is grown already.
+        snapshot_save(snapshot, game);
+
+        double start = now_ns();
+        for (int r = 0; r < BENCH_REPEATS; r++) {
+            snapshot_save(snapshot, game);
+        }
+        double save_us = (now_ns() - start) / BENCH_REPEATS / 1000.0;
+
+        start = now_ns();
+        for (int r = 0; r < BENCH_REPEATS; r++) {
+            snapshot_restore(snapshot, game);
+        }
+        double restore_us = (now_ns() - start) / BENCH_REPEATS / 1000.0;
+
+        // rollback: the same steps from the same snapshot must end up in the same world.
+        Snapshot* first_run = malloc(sizeof(Snapshot));
+        snapshot_init(first_run);
+        run_steps(game, BENCH_ROLLBACK_STEPS, dt);
+        snapshot_save(first_run, game);
+        snapshot_restore(snapshot, game);
+        run_steps(game, BENCH_ROLLBACK_STEPS, dt);
+        Snapshot* second_run = malloc(sizeof(Snapshot));
+        snapshot_init(second_run);
+        snapshot_save(second_run, game);
+        int identical = first_run->size == second_run->size && memcmp(first_run->data, second_run->data, first_run->size) == 0;
+
+        printf("%d,%d,%zu,%.2f,%.2f,%s\n", asteroid_counts[a], blasts, snapshot->size, save_us, restore_us, identical ? "yes" : "NO");
+        snapshot_destroy(first_run);
+        snapshot_destroy(second_run);
+        snapshot_destroy(snapshot);
+        game_instance_destroy(game);
+    }
+    return 0;
+}
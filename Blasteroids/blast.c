@@ -8,19 +8,36 @@
 
 #include "common.h"
 #include "blast.h"
+#include <string.h>
 
 
-int blast_init(Blast* b, float x, float y, float heading)
+// color of each BLAST_COLOR_xxx.
+static const unsigned char blast_palette[][3] = {
+    {255, 255, 255},    // BLAST_COLOR_WHITE
+};
+
+// from velocity to the tip, the velocity is always BLAST_SPEED long.
+#define BLAST_TIP_PER_VELOCITY (BLAST_LENGTH / BLAST_SPEED)
+
+int blast_tip(Blast* b, float* tip_x, float* tip_y)
+{
+    *tip_x = b->x + b->vx * BLAST_TIP_PER_VELOCITY;
+    *tip_y = b->y + b->vy * BLAST_TIP_PER_VELOCITY;
+    return 0;
+}
+
+/*
+ dir_x, dir_y is the unit vector of heading, the ship firing it has it already.
+ */
+int blast_init(Blast* b, float x, float y, float dir_x, float dir_y)
 {
-    // speed and color will be hardcoded for now.
     b->x = x;
     b->y = y;
-    b->heading = heading;
-    
-    // by spec in the book, this should be 3 times the max speed of a space ship.
-    b->speed = MAX_SPEED * 3;
-    b->gone = 0; // 0 == not gone
-    b->color = al_map_rgb(255, 255, 255);
+    // just fired, it hasn't swept anything yet.
+    b->prev_x = x;
+    b->prev_y = y;
+    b->vx = BLAST_SPEED * dir_x;
+    b->vy = BLAST_SPEED * dir_y;
     return 0;
 }
 
@@ -28,24 +45,14 @@ int blast_init(Blast* b, float x, float y, float heading)
  Draw a blast
  
  A blast should be a dash with fixed length.
+ It's added to batch, from x,y towards its velocity, the same as a north line rotated by heading, no transform needed.
  */
-int blast_draw(Blast* b)
-{
-    // draw code goes here.
-    // How to draw:
-    //      1. draw a 0 heading (north) line at first.
-    //      2. transform this line to where it should be. (actual process is the opposite)
-    
-    // setup the transform.
-    ALLEGRO_TRANSFORM transform;
-    al_identity_transform(&transform);
-    // which comes first which comes late matters.
-    //al_scale_transform(&transform, ship->scale, ship->scale);
-    al_rotate_transform(&transform, DEGTORAD(b->heading));
-    al_translate_transform(&transform, b->x, b->y);
-    al_use_transform(&transform);
-    // from 0,0 to 0, -Blast_length,
-    al_draw_line(0, 0, 0, 0-BLAST_LENGTH, b->color, BLAST_WIDTH);
+int blast_draw(Blast* b, float alpha, ALLEGRO_COLOR color, PrimBatch* batch)
+{
+    // blasts never wrap, they are gone at the edge.
+    float x = lerp_f(b->prev_x, b->x, alpha);
+    float y = lerp_f(b->prev_y, b->y, alpha);
+    prim_batch_add_line(batch, x, y, x + b->vx * BLAST_TIP_PER_VELOCITY, y + b->vy * BLAST_TIP_PER_VELOCITY, color, BLAST_WIDTH);
     return 0;
 }
 
@@ -53,14 +60,14 @@ int blast_draw(Blast* b)
  Update a blast to the states of next moment
  
  Move a blast towards [heading] by [speed * delta-time]
- Speed is given, delta-time == 1/FPS
+ Speed is given, delta-time == dt, the sim step
  
  Calculate new x and y, normally return 0;
  if x,y goes out of screen, set x,y to -10,-10 then return 1;
  
- Important: Caller should handle return 1 situation, and delete this blast from the cluster, then destroy both the node and the blast.
+ Important: Caller should handle return 1 situation, and remove this blast from the cluster.
  */
-int blast_update(Blast* b)
+int blast_update(Blast* b, float dt)
 {
     // OFF screen situation,
     if (b->x > BUFFER_WIDTH || b->x < 0 || b->y > BUFFER_HEIGHT || b->y < 0) {
@@ -69,50 +76,170 @@ int blast_update(Blast* b)
         // caller should handle the memory destroy things.
         return 1;
     }
-    // Normal case, update one more step.
-    b->x += b->speed * (1.0/GAME_FPS) * sin(DEGTORAD(b->heading));
-    b->y -= b->speed * (1.0/GAME_FPS) * cos(DEGTORAD(b->heading));
+    // Normal case, remember where it was for swept collision, then update one more step.
+    b->prev_x = b->x;
+    b->prev_y = b->y;
+    b->x += b->vx * dt;
+    b->y += b->vy * dt;
     // 0 == success.
     return 0;
 }
 
 
 
+int blastcluster_init(BlastCluster* blast_cluster, int capacity)
+{
+    blast_cluster->blasts = malloc(capacity * sizeof(Blast));
+    blast_cluster->life_left = malloc(capacity * sizeof(float));
+    blast_cluster->color = malloc(capacity * sizeof(unsigned char));
+    if (!blast_cluster->blasts || !blast_cluster->life_left || !blast_cluster->color) {
+        go_error("Failed when allocating blasts, out of memory.");
+    }
+    blast_cluster->head = 0;
+    blast_cluster->count = 0;
+    blast_cluster->capacity = capacity;
+    blast_cluster->fired = 0;
+    blast_cluster->recycled = 0;
+    blast_cluster->expired = 0;
+    blast_cluster->high_water = 0;
+    handle_table_init(&blast_cluster->handles, capacity);
+    return 0;
+}
+
+int blastcluster_destroy(BlastCluster* blast_cluster)
+{
+    free(blast_cluster->blasts);
+    free(blast_cluster->life_left);
+    free(blast_cluster->color);
+    handle_table_release(&blast_cluster->handles);
+    free(blast_cluster);
+    return 0;
+}
+
 /*
- Destroy one blast node and it's blast. Free the memory.
- 
- Important: This function is supposed to be called only by blastcluster_remove_node(), or the linked list may become broken, and unpredictable errors/bugs could occur.
- 
- This one directly frees the memory the parameter points to, don't do any further check.
+ Append a blast, the oldest one goes if it's full.
  */
+Handle _blastcluster_add(BlastCluster* bc, float x, float y, float dir_x, float dir_y, float lifetime)
+{
+    int i;
+    if (bc->count == bc->capacity) {
+        // full, the oldest one goes.
+        i = bc->head;
+        handle_table_remove(&bc->handles, i);
+        bc->head = (bc->head + 1) % bc->capacity;
+        bc->recycled++;
+    }
+    else {
+        i = (bc->head + bc->count) % bc->capacity;
+        bc->count++;
+        if (bc->count > bc->high_water) {
+            bc->high_water = bc->count;
+        }
+    }
+    blast_init(&bc->blasts[i], x, y, dir_x, dir_y);
+    bc->life_left[i] = lifetime;
+    bc->color[i] = BLAST_COLOR_WHITE;
+    bc->fired++;
+    return handle_table_add(&bc->handles, i);
+}
 
+Handle blastcluster_add_blast(BlastCluster* bc, Spaceship* ship, float lifetime)
+{
+    return _blastcluster_add(bc, ship->x, ship->y, ship->dir_x, ship->dir_y, lifetime);
+}
 
+int blastcluster_record_blast(CommandBuffer* commands, Spaceship* ship, float lifetime)
+{
+    BlastSpawn spawn = { ship->x, ship->y, ship->dir_x, ship->dir_y, lifetime };
+    return command_buffer_record_spawn(commands, &spawn, sizeof(BlastSpawn));
+}
 
-int blastcluster_init(BlastCluster* blast_cluster)
+Blast* blastcluster_at(BlastCluster* bc, int k)
 {
-    generic_cluster_init(blast_cluster);
-    return 0;
+    return &bc->blasts[(bc->head + k) % bc->capacity];
 }
 
-int blastcluster_destroy(BlastCluster* blast_cluster)
+Handle blastcluster_handle(BlastCluster* bc, int k)
+{
+    return handle_table_get(&bc->handles, (bc->head + k) % bc->capacity);
+}
+
+int blastcluster_find(BlastCluster* bc, Handle blast)
+{
+    int i = handle_table_find(&bc->handles, blast);
+    if (i < 0) {
+        return -1;
+    }
+    return (i - bc->head + bc->capacity) % bc->capacity;
+}
+
+int blastcluster_remove(BlastCluster* bc, Handle blast)
 {
-    generic_cluster_destroy(blast_cluster);
+    int i = handle_table_find(&bc->handles, blast);
+    if (i < 0) {
+        return -1;
+    }
+    bc->life_left[i] = 0;
     return 0;
 }
 
-int blastcluster_add_blast(BlastCluster* bc, Spaceship* ship)
+int blastcluster_remove_gone(BlastCluster* bc)
 {
-    Blast* rb;  // rb = real blast
-    rb = malloc(sizeof(Blast));
-    blast_init(rb, ship->x, ship->y, ship->heading);
-    
-    generic_cluster_add_node(bc, rb);
+    // the ones left slide towards head, in order, one pass.
+    int kept = 0;
+    for (int k = 0; k < bc->count; k++) {
+        int from = (bc->head + k) % bc->capacity;
+        if (bc->life_left[from] <= 0) {
+            handle_table_remove(&bc->handles, from);
+            continue;
+        }
+        if (kept != k) {
+            int to = (bc->head + kept) % bc->capacity;
+            handle_table_move(&bc->handles, from, to);
+            bc->blasts[to] = bc->blasts[from];
+            bc->life_left[to] = bc->life_left[from];
+            bc->color[to] = bc->color[from];
+        }
+        kept++;
+    }
+    bc->count = kept;
     return 0;
 }
 
-int blastcluster_remove_node(BlastCluster* bc, BlastClusterNode* bn_to_remove)
+int blastcluster_apply(BlastCluster* bc, CommandBuffer* commands)
 {
-    generic_cluster_remove_node(bc, bn_to_remove);
+    if (commands->count == 0) {
+        return 0;
+    }
+    // the removes first, all of them marked then dropped in one pass...
+    int removed = 0;
+    for (int c = 0; c < commands->count; c++) {
+        Command* command = &commands->commands[c];
+        if (command->type != COMMAND_REMOVE) {
+            continue;
+        }
+        if (blastcluster_remove(bc, command->target) < 0) {
+            commands->stale++;
+        }
+        else {
+            commands->applied++;
+            removed++;
+        }
+    }
+    if (removed) {
+        blastcluster_remove_gone(bc);
+    }
+    // ...then the spawns, in the order fired, so a full ring only recycles what's really left.
+    for (int c = 0; c < commands->count; c++) {
+        Command* command = &commands->commands[c];
+        if (command->type != COMMAND_SPAWN) {
+            continue;
+        }
+        BlastSpawn* spawn = command_buffer_spawn_data(commands, command);
+        _blastcluster_add(bc, spawn->x, spawn->y, spawn->dir_x, spawn->dir_y, spawn->lifetime);
+        commands->applied++;
+    }
+    command_buffer_clear(commands);
     return 0;
 }
 
@@ -120,7 +247,7 @@ int blastcluster_remove_node(BlastCluster* bc, BlastClusterNode* bn_to_remove)
 /*
  Iterate through all blasts, update each one's status.
  1. move every blast forward a little step;
- 2. check if anyone exceeds the border of the screen, remove if any.
+ 2. check if anyone exceeds the border of the screen, or its lifetime, record a remove if any, it's gone when commands is applied (blastcluster_apply()).
  
  Important: this assume for each frame draw, the COLLISION detection should be performed first, so that all the ones left, should not collide with other elements. So simply move all blasts forward a step will not cause contradictories. (a blast and a asteroid at the edge of the screen, collide always checks first) If after this update, should any of the blast collide with any asteroid, it's the next run's reposibility to check this collision and make the correct response. (blast hit a asteroid should be handled in the next run, nothing will miss).
  
@@ -128,44 +255,81 @@ int blastcluster_remove_node(BlastCluster* bc, BlastClusterNode* bn_to_remove)
  
  */
 
-/*
- local helper function, handle the off screen situaions
- */
-int _blast_update_result_handler(GenerictCluster* gc, GenericClusterNode* cn, int ret_code)
+int blastcluster_update(BlastCluster* bc, float dt, CommandBuffer* commands)
 {
-    if (ret_code == 1)
-        blastcluster_remove_node(gc, cn);
+    for (int k = 0; k < bc->count; k++) {
+        int i = (bc->head + k) % bc->capacity;
+        if (blast_update(&bc->blasts[i], dt) == 1) {
+            // off screen.
+            command_buffer_record_remove(commands, handle_table_get(&bc->handles, i));
+            continue;
+        }
+        bc->life_left[i] -= dt;
+        if (bc->life_left[i] <= 0) {
+            // too old.
+            bc->expired++;
+            command_buffer_record_remove(commands, handle_table_get(&bc->handles, i));
+        }
+    }
     return 0;
 }
+
 /*
- Pass blast_update directly to the iterator will cause a warning on function pointer's parameter type not match, to supress this, use this wrapper, to "cast" the function type to void, so that means, we are gonna past this Blast* function to somewhere expect it to be a void*
+ Draw all the blast
  */
-int _blast_update_wrapper(void* blast)
+int blastcluster_draw(BlastCluster* bc, float alpha, PrimBatch* batch)
 {
-    // explicitly cast the parameter type from void to Blast.
-    return blast_update((Blast*)blast);
+    for (int k = 0; k < bc->count; k++) {
+        int i = (bc->head + k) % bc->capacity;
+        const unsigned char* rgb = blast_palette[bc->color[i]];
+        blast_draw(&bc->blasts[i], alpha, al_map_rgb(rgb[0], rgb[1], rgb[2]), batch);
+    }
+    return 0;
 }
 
-int blastcluster_update(BlastCluster* bc)
+int blastcluster_print_stats(BlastCluster* bc)
 {
-    // For each blast in this blustcluster,
-    // DO blast_update()
-    // Then handle the result (ret code) of each object, in _blast_update_result_handler()
-    generic_cluster_iterate_and_do(bc, _blast_update_wrapper, _blast_update_result_handler);
+    size_t cold = sizeof(float) + sizeof(unsigned char);
+    // allocated once at init, so no heap calls after it.
+    printf("blasts: ring of %d, %zu bytes a blast, %zu hot, %zu cold, live %d, high-water %d, fired %ld, expired %ld, recycled %ld\n",
+           bc->capacity, sizeof(Blast) + cold, sizeof(Blast), cold, bc->count, bc->high_water, bc->fired, bc->expired, bc->recycled);
     return 0;
 }
 
-/*
- Draw all the blast
- */
-int _blast_draw_wrapper(void* blast)
+size_t blastcluster_packed_size(BlastCluster* bc)
 {
-    // explicitly cast the parameter type from void to Blast.
-    return blast_draw((Blast*)blast);
+    return (size_t)bc->count * (sizeof(Blast) + sizeof(float) + sizeof(unsigned char)) + handle_table_packed_size(&bc->handles, bc->count);
 }
 
-int blastcluster_draw(BlastCluster* bc)
+int blastcluster_pack(BlastCluster* bc, void* dst)
 {
-    generic_cluster_iterate_and_do(bc, _blast_draw_wrapper, NULL);
+    Blast* blasts = dst;
+    float* life_left = (float*)(blasts + bc->count);
+    unsigned char* color = (unsigned char*)(life_left + bc->count);
+    for (int k = 0; k < bc->count; k++) {
+        int i = (bc->head + k) % bc->capacity;
+        blasts[k] = bc->blasts[i];
+        life_left[k] = bc->life_left[i];
+        color[k] = bc->color[i];
+    }
+    handle_table_pack(&bc->handles, color + bc->count, bc->count, bc->head, bc->capacity);
+    return 0;
+}
+
+int blastcluster_unpack(BlastCluster* bc, const void* src, int count)
+{
+    if (count > bc->capacity) {
+        go_error("More blasts than the ring holds.");
+    }
+    // back into the ring from its start.
+    const Blast* blasts = src;
+    const float* life_left = (const float*)(blasts + count);
+    const unsigned char* color = (const unsigned char*)(life_left + count);
+    memcpy(bc->blasts, blasts, count * sizeof(Blast));
+    memcpy(bc->life_left, life_left, count * sizeof(float));
+    memcpy(bc->color, color, count * sizeof(unsigned char));
+    bc->head = 0;
+    bc->count = count;
+    handle_table_unpack(&bc->handles, color + count, count);
     return 0;
 }
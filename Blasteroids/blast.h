@@ -10,97 +10,157 @@
 #define blast_h
 
 #include "spaceship.h"
-#include "cluster.h"
+#include "prim_batch.h"
+#include "handle.h"
+#include "command_buffer.h"
 
 /*
- Blast, purely for what a blast is.
+ Blast, purely for what a blast is, what update, collision and drawing go through every tick. 24 bytes.
+ 
+ Every blast flies at BLAST_SPEED, heading never changes, so velocity is all it needs of heading and speed.
+ The dash goes from x,y to its tip, BLAST_LENGTH ahead along the velocity: x + vx * BLAST_LENGTH / BLAST_SPEED.
+ What's not needed every tick, the lifetime and the color, is kept by the cluster next to it (cold).
  */
 typedef struct {
     float x;
     float y;
-    float heading;
-    float speed;
-    int gone; // 1 = gone, 0 = not gone.
-    ALLEGRO_COLOR color;
+    float prev_x;   // where it was last tick, for swept collision and render interpolation.
+    float prev_y;
+    float vx, vy;   // in px/second.
 } Blast;
 
+// the only color of the blasts for now, index into the palette.
+#define BLAST_COLOR_WHITE 0
+
 /*
- Node of a double directional linked list to track all the blasts.
+ Blastcluster - all the blasts in the air, a ring of capacity Blasts, allocated once when it's created.
  
- 1:1 mapping to Blast. Only handle linked list related operations.
+ The blasts are in the order they were fired: the oldest at head, count of them after it, wrapping around the end of the array.
+ Firing appends after the last one. When the ring is full, the new blast takes the place of the oldest (recycled), so there are never more than capacity blasts, and the blast memory and the collision cost of a tick have a hard upper bound.
+ A blast is gone when it hits something, leaves the screen, or flew its lifetime. Gone ones are marked (no life left), then dropped all at once by blastcluster_remove_gone(), the rest keep their order.
+ The game never adds or drops one while a stage goes through the ring, firing and what's gone are recorded as commands (command_buffer.h), applied at the end of the stage.
  
- Blast itself should not contain certain data structrue information, that's not its job.
+ Hot and cold: the Blasts are in one array, life_left and the color (an index into the palette) in arrays of their own, the same index in the ring.
  
- last node: next == NULL;
- first node: prev == NULL;
+ The k-th oldest blast is blastcluster_at(bc, k), k from 0 to count - 1, it's only good until the next add or remove.
+ Held across those, a blast is its handle (handle.h), blastcluster_find() gives its k now, or -1 once it's gone (dropped or recycled). Removing goes by handle.
  
- 1 node situation: next == NULL and prev == NULL;
- 0 node situation: no node at all. (Cluster should handle this.)
+ Public functions:
+    init(capacity)
+    add_blast(&spaceship, lifetime) -- use the x,y,heading of the spaceship to create a blast, add it to the cluster.
+    remove(handle) -- mark a blast gone.
+    remove_gone() -- drop the blasts marked gone.
+    record_blast(&commands, &spaceship, lifetime) -- the same as add_blast, recorded as a spawn.
+    apply(&commands) -- every blast a remove names is gone, dropped in one pass, then the spawns are added.
+    update(dt, &commands) -- move all the blasts forward, record a remove for the ones off screen or too old.
+    draw(alpha, &batch) -- draw each one of them.
  
+ Firing is up to the weapon (weapon.h), it decides how often.
+ */
+typedef struct {
+    Blast* blasts;  // capacity of them, a ring.
+    // cold, the same ring.
+    float* life_left;   // in seconds, gone when it's used up.
+    unsigned char* color;   // BLAST_COLOR_xxx
+    HandleTable handles;    // by index in the ring, not by k.
+    int head;       // the oldest one.
+    int count;
+    int capacity;
+    long fired;
+    long recycled;  // fired over the oldest one, the ring was full.
+    long expired;   // flew their whole lifetime.
+    int high_water;     // the most blasts in the air at once, capacity is enough as long as it stays below.
+} BlastCluster;
+
+/*
+ Return an empty blastcluster, room for capacity blasts.
  */
+int blastcluster_init(BlastCluster* blast_cluster, int capacity);
 
-//typedef struct BlastClusterNode {
-//    Blast* real_blast;
-//    struct BlastClusterNode* prev;
-//    struct BlastClusterNode* next;
-//} BlastClusterNode;
+int blastcluster_destroy(BlastCluster* blast_cluster);
 
 /*
- Now we use GenericClusterNode as BlastClusterNode's data structure behind the scene.
+ Add a new blast from current ship's location, gone after lifetime seconds. Return its handle.
  */
-typedef GenericClusterNode BlastClusterNode;
+Handle blastcluster_add_blast(BlastCluster* bc, Spaceship* ship, float lifetime);
 
 /*
- Double directional linked list, store all the blasts.
- 
- 0 element situation: fn == NULL, ln == NULL
- 1 element situation: fn == the same one itself, ln == the same one itself
- 2 and above: fn == 1st, ln = 2nd or after.
+ A blast as recorded by blastcluster_record_blast(), for a spawn command.
  */
-//typedef struct {
-//    BlastClusterNode* first_node; // could be NULL, == no blast on screen.
-//    BlastClusterNode* last_node; // for quick insertion. could be NULL, == no blast on screen.
-//} BlastCluster;
-typedef GenerictCluster BlastCluster;
+typedef struct {
+    float x, y;
+    float dir_x, dir_y;
+    float lifetime;
+} BlastSpawn;
 
 /*
- Blastcluster - the double directional linked list to hold all the blast.
- 
- This should be the public handler of all the blust related operation.
- 
- Public functions:
-    init(no param)
-    new_blast(&spaceship) -- use the x,y,heading of the spaceship to create a blast, add it to the cluster.
-    remove_blast(&BlastClusterNode) -- remove this node from cluster, and destroy node and blast.
-    update_all_blasts(no param) -- iterate through all the nodes, move forward one step.
-    draw_all_blasts(no param) -- iterate through all the nodes, draw each one of them.
- 
- Note:
-    Blast and BlastClusterNode should be private.
-    All the blast related operations should be performed through BlastCluster.
+ Record a spawn of the blast blastcluster_add_blast() would add, it's added by blastcluster_apply().
+ */
+int blastcluster_record_blast(CommandBuffer* commands, Spaceship* ship, float lifetime);
 
+/*
+ The k-th oldest blast.
  */
+Blast* blastcluster_at(BlastCluster* bc, int k);
 
 /*
- Return an empty blastcluster
+ Handle of the k-th oldest blast.
  */
-int blastcluster_init(BlastCluster* blast_cluster);
+Handle blastcluster_handle(BlastCluster* bc, int k);
 
-int blastcluster_destroy(BlastCluster* blast_cluster);
+/*
+ k of the blast now, -1 if it's gone.
+ */
+int blastcluster_find(BlastCluster* bc, Handle blast);
 
 /*
- Add a new blast from current ship's location.
+ Mark the blast gone, it's dropped by the next blastcluster_remove_gone(), its handle is stale from then on. Return -1 if it was gone already.
  */
-int blastcluster_add_blast(BlastCluster* bc, Spaceship* ship);
+int blastcluster_remove(BlastCluster* bc, Handle blast);
 
 /*
- Remove one blast
+ Drop every blast marked gone, the others keep their order.
  */
-int blastcluster_remove_node(BlastCluster* bc, BlastClusterNode* bn_to_remove);
+int blastcluster_remove_gone(BlastCluster* bc);
 
-int blastcluster_draw(BlastCluster* bc);
+/*
+ Apply every command recorded in commands (command_buffer.h), then empty it. The removes first: all of them are marked, then dropped by one blastcluster_remove_gone(). Then the spawns, in the order recorded.
+ */
+int blastcluster_apply(BlastCluster* bc, CommandBuffer* commands);
+
+/*
+ The dash of a blast, from x,y to the tip.
+ */
+int blast_tip(Blast* b, float* tip_x, float* tip_y);
+
+/*
+ Size in bytes of the blasts packed by blastcluster_pack(), hot and cold.
+ */
+size_t blastcluster_packed_size(BlastCluster* bc);
+
+/*
+ Copy every blast into dst, oldest first, the Blasts then each cold array, then the handle table. dst has to hold blastcluster_packed_size() bytes.
+ */
+int blastcluster_pack(BlastCluster* bc, void* dst);
+
+/*
+ Replace every blast with the count ones packed in src by blastcluster_pack(), count is at most capacity.
+ The handles are as they were when packed, the same as asteroids (asteroid_cluster_unpack()).
+ */
+int blastcluster_unpack(BlastCluster* bc, const void* src, int count);
+
+/*
+ Draw all, at alpha (0-1) of the way from the previous sim step to the current one.
+ They are only added to batch, caller flushes it.
+ */
+int blastcluster_draw(BlastCluster* bc, float alpha, PrimBatch* batch);
+
+/*
+ Move all forward by dt seconds, record a remove into commands for the ones off screen or out of lifetime.
+ */
+int blastcluster_update(BlastCluster* bc, float dt, CommandBuffer* commands);
 
-int blastcluster_update(BlastCluster* bc);
+int blastcluster_print_stats(BlastCluster* bc);
 
 
 #endif /* blast_h */
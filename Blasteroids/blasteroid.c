@@ -7,17 +7,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <time.h>
 #include <allegro5/allegro5.h>
 #include <allegro5/allegro_font.h>
 #include <allegro5/allegro_primitives.h>
 #include "common.h"
-#include "blast.h"
-#include "spaceship.h"
-#include "lifecounter.h"
-#include "score.h"
-#include "asteroids.h"
-#include "collision.h"
-#include "level.h"
+#include "game.h"
+#include "aabb_batch.h"
+#include "config.h"
+#include "prim_batch.h"
+#include "replay.h"
+#include "trace.h"
+#include "sim_thread.h"
 
 /*
  "Our Allegro Instance"
@@ -32,19 +33,69 @@ typedef struct {
     ALLEGRO_DISPLAY* disp;
     ALLEGRO_BITMAP* buffer;
     ALLEGRO_FONT* font;
+    Renderer* renderer; // allegro, or null when headless.
+    PrimBatch* batch;   // asteroids, blasts and particles, one draw call for all.
+    Replay* replay;     // recording the input, or playing it back instead of the keyboard.
+    SimThread* sim;     // the sim on its own thread, NULL == the sim runs in the main loop.
+    // HUD and overlay text drawn once into bitmaps, drawn again only when they change.
+    HudCache hud_score;
+    HudCache hud_lives;
+    HudCache hud_overlay;
     ALLEGRO_EVENT event;
     bool done;
     bool redraw;
     unsigned char key[ALLEGRO_KEY_MAX];
+    // sim clock: real time not yet simulated piles up in accumulator, sim eats it dt by dt.
+    double last_time;
+    double accumulator;
+    long sim_steps;
 } OUR_AL_INSTANCE;
 
-// allegro related initialization
-int our_al_instance_init(OUR_AL_INSTANCE* al)
+/*
+ allegro related initialization
+ 
+ headless: no display, keyboard, timer or event queue, they are left NULL, it draws to the null renderer.
+ */
+int our_al_instance_init(OUR_AL_INSTANCE* al, GameConfig* config)
 {
     must_init(al_init(), "allegro");
+    // Font, use the built-in one.
+    al->font = al_create_builtin_font();
+    must_init(al->font, "font");
+    // Primitives for draw everything.
+    must_init(al_init_primitives_addon(), "primitives");
+    al->batch = malloc(sizeof(PrimBatch));
+    prim_batch_init(al->batch);
+    al->renderer = malloc(sizeof(Renderer));
+    
+    // Key status array, Allegro tutorial's keyboard handling.
+    memset(al->key, 0, sizeof(al->key));
+    
+    // Exit flag
+    al->done = false;
+    // Draw flag
+    al->redraw = true;
+    
+    al->last_time = al_get_time();
+    al->accumulator = 0;
+    al->sim_steps = 0;
+    al->sim = NULL;
+    hud_cache_init(&al->hud_score);
+    hud_cache_init(&al->hud_lives);
+    hud_cache_init(&al->hud_overlay);
+    
+    if (config->headless) {
+        al->timer = NULL;
+        al->queue = NULL;
+        al->disp = NULL;
+        al->buffer = NULL;
+        renderer_init_null(al->renderer);
+        return 0;
+    }
+    
     must_init(al_install_keyboard(), "keyboard");
-    // Timer, ticks at 1/FPS second.
-    al->timer = al_create_timer(1.0 / GAME_FPS);
+    // Timer, ticks at the render rate, the sim keeps its own pace from al_get_time().
+    al->timer = al_create_timer(1.0 / config->render_hz);
     must_init(al->timer, "timer");
     // Event queue
     al->queue = al_create_event_queue();
@@ -53,16 +104,19 @@ int our_al_instance_init(OUR_AL_INSTANCE* al)
     al_set_new_display_option(ALLEGRO_SAMPLE_BUFFERS, 1, ALLEGRO_SUGGEST);
     al_set_new_display_option(ALLEGRO_SAMPLES, 8, ALLEGRO_SUGGEST);
     al_set_new_bitmap_flags(ALLEGRO_MIN_LINEAR | ALLEGRO_MAG_LINEAR);
-    al->disp = al_create_display(DISP_WIDTH, DISP_HEIGHT);
+    al->disp = al_create_display(BUFFER_WIDTH * config->scale, BUFFER_HEIGHT * config->scale);
     must_init(al->disp, "display");
-    // Draw Buffer for scale
-    al->buffer = al_create_bitmap(BUFFER_WIDTH, BUFFER_HEIGHT);
-    must_init(al->buffer, "bitmap buffer");
-    // Font, use the built-in one.
-    al->font = al_create_builtin_font();
-    must_init(al->font, "font");
-    // Primitives for draw everything.
-    must_init(al_init_primitives_addon(), "primitives");
+    if (config->direct) {
+        // no buffer, the renderer scales every draw onto the display.
+        al->buffer = NULL;
+        renderer_init_allegro_direct(al->renderer, al->disp, config->scale);
+    }
+    else {
+        // Draw Buffer for scale
+        al->buffer = al_create_bitmap(BUFFER_WIDTH, BUFFER_HEIGHT);
+        must_init(al->buffer, "bitmap buffer");
+        renderer_init_allegro(al->renderer, al->disp, al->buffer, config->scale);
+    }
     // Wire up events.
     al_register_event_source(al->queue, al_get_keyboard_event_source());
     al_register_event_source(al->queue, al_get_display_event_source(al->disp));
@@ -70,111 +124,47 @@ int our_al_instance_init(OUR_AL_INSTANCE* al)
     
     // event doesn't need init.
     
-    // Key status array, Allegro tutorial's keyboard handling.
-    memset(al->key, 0, sizeof(al->key));
-    
-    // Exit flag
-    al->done = false;
-    // Draw flag
-    al->redraw = true;
-    
     return 0;
 }
 
 int our_al_instance_destroy(OUR_AL_INSTANCE* al)
 {
+    replay_destroy(al->replay);
+    // the cached bitmaps go before the renderer that made them.
+    hud_cache_release(&al->hud_score, al->renderer);
+    hud_cache_release(&al->hud_lives, al->renderer);
+    hud_cache_release(&al->hud_overlay, al->renderer);
+    renderer_destroy(al->renderer);
+    prim_batch_destroy(al->batch);
     al_destroy_font(al->font);
-    al_destroy_bitmap(al->buffer);
-    al_destroy_display(al->disp);
-    al_destroy_timer(al->timer);
-    al_destroy_event_queue(al->queue);
+    // nothing of these when headless.
+    if (al->disp) {
+        // no buffer when drawing direct.
+        if (al->buffer) {
+            al_destroy_bitmap(al->buffer);
+        }
+        al_destroy_display(al->disp);
+        al_destroy_timer(al->timer);
+        al_destroy_event_queue(al->queue);
+    }
     free(al);
     return 0;
 }
 
-/*
- Game Instance
- 
- Game instance is to wrap everything we have around, as a game instance, so that we could pass it around, move game related logic out from main.
- It also give you a clear mind what's in our game.
- 
- */
-
-typedef struct {
-    Spaceship* ship;    // the ship
-    LifeCounter* life_counter;
-    Score* score;
-    BlastCluster* all_blasts;   // all the blasts
-    Level* level;       // level 1, 2, 3...
-    AsteroidCluster* all_asteroids;    // all the asteroids.
-} GAME_INSTANCE;
-
-int game_instance_init(GAME_INSTANCE* game)
-{
-    game->ship = malloc(sizeof(Spaceship));
-    spaceship_init(game->ship, BUFFER_WIDTH/2.0, BUFFER_HEIGHT/2.0);  // space ship takes 2 float position to init, we put it on the center of the screen.
-    
-    game->life_counter = malloc(sizeof(LifeCounter));
-    lifecounter_init(game->life_counter);
-    
-    game->score = malloc(sizeof(Score));
-    // init score, params: &s, position_x, position_y, size_scale_factor
-    score_init(game->score);
-    
-    // blasts
-    game->all_blasts = malloc(sizeof(BlastCluster));
-    blastcluster_init(game->all_blasts);
-    
-    // level
-    game->level = malloc(sizeof(Level));
-    level_first_init(game->level);    // level 1 as started.
-    
-    // Asteroids
-    game->all_asteroids = malloc(sizeof(AsteroidCluster));
-    asteroid_cluster_init(game->all_asteroids);
-    //it's a special case, when the game just launch, we have to init level 1's asteroids.
-    asteroid_cluster_add_some_random_asteroids(game->all_asteroids, game->level->asteroid_total);
-    
-    return 0;
-}
-
-int game_instance_destroy(GAME_INSTANCE* game)
-{
-    spaceship_destroy(game->ship);
-    lifecounter_destroy(game->life_counter);
-    score_destroy(game->score);
-    blastcluster_destroy(game->all_blasts);
-    asteroid_cluster_destroy(game->all_asteroids);
-    level_destroy(game->level);
-    free(game);
-    return 0;
-}
-
-/* Process keyboard event so that our spaceship could move properly */
-static void process_keyboard_events_the_right_way(OUR_AL_INSTANCE **al, GAME_INSTANCE *game) {
+/* Process keyboard event, into the input mask of this tick */
+static unsigned char process_keyboard_events_the_right_way(OUR_AL_INSTANCE **al) {
     // UP, DOWN, LEFT, RIGHT, SPACE, for spaceship action.
-    if (game->level->game_status < GAME_OVER) {
-        if((*al)->key[ALLEGRO_KEY_UP]) {
-            spaceship_accelerate(game->ship);
-        }
-        if((*al)->key[ALLEGRO_KEY_DOWN]) {
-            spaceship_decelerate(game->ship);
-        }
-        if((*al)->key[ALLEGRO_KEY_LEFT]) {
-            spaceship_turn_left(game->ship);
-        }
-        if((*al)->key[ALLEGRO_KEY_RIGHT]) {
-            spaceship_turn_right(game->ship);
-        }
-        if((*al)->key[ALLEGRO_KEY_SPACE]) {
-            // press space, add a blast
-            blastcluster_add_blast(game->all_blasts, game->ship);
-            // -- not good -- only respond to fire after level start
-//            if (game->level->game_status > LEVEL_START) {
-//                blastcluster_add_blast(game->bc, game->ship);
-//            }
-        }
-    }
+    unsigned char mask = 0;
+    if((*al)->key[ALLEGRO_KEY_UP])
+        mask |= INPUT_UP;
+    if((*al)->key[ALLEGRO_KEY_DOWN])
+        mask |= INPUT_DOWN;
+    if((*al)->key[ALLEGRO_KEY_LEFT])
+        mask |= INPUT_LEFT;
+    if((*al)->key[ALLEGRO_KEY_RIGHT])
+        mask |= INPUT_RIGHT;
+    if((*al)->key[ALLEGRO_KEY_SPACE])
+        mask |= INPUT_FIRE;
     
     // ESC to quit game.
     if((*al)->key[ALLEGRO_KEY_ESCAPE])
@@ -183,101 +173,67 @@ static void process_keyboard_events_the_right_way(OUR_AL_INSTANCE **al, GAME_INS
     // Refresh keyboard stuff "the right way", it's from allegro's tutorial.
     for(int i = 0; i < ALLEGRO_KEY_MAX; i++)
         (*al)->key[i] &= KEY_SEEN;
+    return mask;
 }
 
-static void game_move_to_next_level(GAME_INSTANCE *game) {
-    level_go_next(game->level);
-    // Re-prepare the asteroids of next level.
-    asteroid_cluster_add_some_random_asteroids(game->all_asteroids, game->level->asteroid_total);
-    // No need to center the ship, it feels bad.
-    //        spaceship_reset_to_center((*game)->ship);
-    // Life ++ ???
-    lifecounter_add_one_life(game->life_counter);
-}
 
-static void run_main_game_logic(GAME_INSTANCE *game) {
-    if (ship_crash_detection(game->all_asteroids, game->ship))
-    {
-        if (life_after_die_once(game->life_counter)==0) {
-            // if life == 0, game over
-            game->level->game_status = GAME_OVER;
-        }
-        // this will set the invicible time.
-        spaceship_just_hit(game->ship);
+/* One fixed sim step of dt seconds: input, logic, move. */
+static void run_one_sim_step(OUR_AL_INSTANCE *al, GAME_INSTANCE *game, float dt) {
+    // input of this tick, from keyboard, or from the replay if playing one.
+    unsigned char mask = process_keyboard_events_the_right_way(&al);
+    if (replay_apply(al->replay, &mask)) {
+        // the recording is over, so is the session.
+        al->done = true;
+        return;
     }
     
-    // Run through all the asteroids and blasts, see if any got hit, the result score increment will be returned by asteroid_hit_detection().
-    game->score->score += asteroid_hit_detection(game->all_asteroids, game->all_blasts);
-}
-
-static bool check_if_wins(GAME_INSTANCE *game) {
-    if (!(game->all_asteroids->first_node)) {
-        game->level->game_status = LEVEL_WIN;
-        return true;
-    }
-    else return false;
-}
-
-/* Run game logic to determined what's happened */
-static void run_game_logic(GAME_INSTANCE *game) {
-    /*
-     By default, the main game logic (detects if spaceship got hit, blast hit asteroids...) should always run.
-     Unless it's GAME_OVER which should do nothing, or NEXT_LEVEL which is a intermediate state to change game instance to next level. (prepare new asteroids, etc...)
-     
-     When and only when IN_GAME_PLAY, should always check if now level wins.
-     In other states, which is mostly for overlay text to display properly for a specific seconds, just count down the countdown ticker.
-     
-     */
-    switch (game->level->game_status) {
-        case GAME_OVER: break;
-        case NEXT_LEVEL:
-            // Move to next level.
-            game_move_to_next_level(game);
-            break;
-            
-        case IN_GAME_PLAY:
-            // If IN_GAME_PLAY check if win, then tick (nothing will happen), then hit detection.
-            // After run through all the asteroids, and no asteroid is left, you win this level, tell LEVEL you are win. (move to next level thigns happens there)
-            check_if_wins(game); // fall through
-        case NEW_LEVEL_NUMBER:
-        case LEVEL_START:
-        case LEVEL_WIN:
-            // NEW_LEVEL_NUMBER, LEVEL_START, LEVEL_WIN: tick(count down) then check hit.
-            level_tick(game->level);
-            // fall through
-        default:
-            // unless GAME_OVER or switch to NEXT_LEVEL, game logic should always run.
-            // Spaceship crash detection, crash has a high priority than other collisions.
-            run_main_game_logic(game);
-            break;
-    }
+    uint64_t t = trace_begin();
+    game_step(game, mask, dt);
+    trace_end("sim_step", t);
+    al->sim_steps++;
 }
 
-/* Update all moving elements on the screen */
-static void update_and_move(GAME_INSTANCE *game) {
-    // -- Not good -- All moving elements only get moved when IN_GAME_PLAY, otherwise it should be in a pause.
-    if (1) {
-        blastcluster_update(game->all_blasts);  // blasters move
-        asteroid_cluster_update(game->all_asteroids);  // asteroids move
-        spaceship_update(game->ship);   // spaceship move
+/*
+ Run as many sim steps as the real time passed since last frame covers, the rest stays in the accumulator for next frame.
+ Return how far (0-1) the real time is between the last step and the next one, for interpolation.
+ */
+static float advance_sim_clock(OUR_AL_INSTANCE *al, GAME_INSTANCE *game, float dt) {
+    double now = al_get_time();
+    double frame_time = now - al->last_time;
+    al->last_time = now;
+    al->accumulator += frame_time > MAX_FRAME_TIME ? MAX_FRAME_TIME : frame_time;
+    while (al->accumulator >= dt && !al->done) {
+        run_one_sim_step(al, game, dt);
+        al->accumulator -= dt;
     }
+    return (float)(al->accumulator / dt);
 }
 
-static void draw_everything_to_buffer(OUR_AL_INSTANCE *al, GAME_INSTANCE *game) {
-    // set draw target to our buffer
-    al_set_target_bitmap(al->buffer);
-    // clear the screen to black.
-    al_clear_to_color(al_map_rgb(0, 0, 0));
+static void draw_everything(OUR_AL_INSTANCE *al, GAME_INSTANCE *game, float alpha) {
+    Renderer* r = al->renderer;
+    uint64_t t = trace_begin();
+    // draw into the buffer, cleared to black.
+    render_begin_frame(r, al_map_rgb(0, 0, 0));
     
     // always draw blasts, asteroids, life counter and score.
-    blastcluster_draw(game->all_blasts);
-    asteroid_cluster_draw(game->all_asteroids);  // draw asteroids.
-    lifecounter_draw(game->life_counter);
-    score_draw(game->score);
+    uint64_t t_cluster = trace_begin();
+    blastcluster_draw(game->all_blasts, alpha, al->batch);
+    trace_end("blastcluster_draw", t_cluster);
+    t_cluster = trace_begin();
+    asteroid_cluster_draw(game->all_asteroids, alpha, al->batch);  // draw asteroids.
+    trace_end("asteroid_cluster_draw", t_cluster);
+    t_cluster = trace_begin();
+    particle_pool_draw(game->particles, alpha, al->batch);
+    trace_end("particle_pool_draw", t_cluster);
+    t_cluster = trace_begin();
+    prim_batch_flush(al->batch, r);    // blasts, asteroids and particles go out in one draw call.
+    trace_end("prim_batch_flush", t_cluster);
+    lifecounter_draw(game->life_counter, r, &al->hud_lives);
+    score_draw(game->score, r, al->font, &al->hud_score);
     
     // Draw the damm ship if it's not game over.
     if (game->level->game_status < GAME_OVER) {
-        spaceship_draw(game->ship);
+        spaceship_draw(game->ship, alpha, r);
     }
     
     // draw overlay text (level X, win, game over...) if status indicates should draw.
@@ -285,44 +241,142 @@ static void draw_everything_to_buffer(OUR_AL_INSTANCE *al, GAME_INSTANCE *game)
         case IN_GAME_PLAY:
             break;
         case GAME_OVER:
-            draw_text_center_overlay(al->font, BUFFER_WIDTH/2.0, BUFFER_HEIGHT/2.0-10, al_map_rgb(192, 57, 50), al_premul_rgba(255, 255, 255, 0), 10, "GAME OVER");
+            draw_text_center_overlay(r, &al->hud_overlay, al->font, BUFFER_WIDTH/2.0, BUFFER_HEIGHT/2.0-10, al_map_rgb(192, 57, 50), al_premul_rgba(255, 255, 255, 0), 10, "GAME OVER");
             break;
         case NEW_LEVEL_NUMBER:
-            draw_level_center_overlay(al->font, BUFFER_WIDTH/2.0, BUFFER_HEIGHT/2.0-10, al_map_rgb(192, 57, 50), al_premul_rgba(255, 255, 255, 0), 10, game->level->level_number);
+            draw_level_center_overlay(r, &al->hud_overlay, al->font, BUFFER_WIDTH/2.0, BUFFER_HEIGHT/2.0-10, al_map_rgb(192, 57, 50), al_premul_rgba(255, 255, 255, 0), 10, game->level->level_number);
             break;
         case LEVEL_START:
-            draw_text_center_overlay(al->font, BUFFER_WIDTH/2.0, BUFFER_HEIGHT/2.0-10, al_map_rgb(192, 57, 50), al_premul_rgba(255, 255, 255, 0), 10, "START");
+            draw_text_center_overlay(r, &al->hud_overlay, al->font, BUFFER_WIDTH/2.0, BUFFER_HEIGHT/2.0-10, al_map_rgb(192, 57, 50), al_premul_rgba(255, 255, 255, 0), 10, "START");
             break;
         case LEVEL_WIN:
-            draw_text_center_overlay(al->font, BUFFER_WIDTH/2.0, BUFFER_HEIGHT/2.0-10, al_map_rgb(192, 57, 50), al_premul_rgba(255, 255, 255, 0), 10, "YOU WIN!");
+            draw_text_center_overlay(r, &al->hud_overlay, al->font, BUFFER_WIDTH/2.0, BUFFER_HEIGHT/2.0-10, al_map_rgb(192, 57, 50), al_premul_rgba(255, 255, 255, 0), 10, "YOU WIN!");
             break;
             
         default:
             break;
     }
-     
-    al_set_target_backbuffer(al->disp); // Set draw target back to screen.
+    
+    trace_end("draw_everything_to_buffer", t);
+    
+    // buffer to actual screen, with proper scale, everything just drawn shows on screen.
+    t = trace_begin();
+    render_end_frame(r);
+    trace_end("draw_buffer_to_screen", t);
 }
 
-static void draw_buffer_to_screen(OUR_AL_INSTANCE *al) {
-    al_set_target_backbuffer(al->disp);
-    al_draw_scaled_bitmap(al->buffer, 0, 0, BUFFER_WIDTH, BUFFER_HEIGHT, 0, 0, DISP_WIDTH, DISP_HEIGHT, 0);     // Scale happens here,
-    al_flip_display();
+/*
+ Threaded: hand the input of this frame to the sim thread, draw the latest world it has published.
+ view is the render thread's own game, only for drawing, the snapshot is restored into it.
+ */
+static void run_threaded_frame(OUR_AL_INSTANCE *al, GAME_INSTANCE *view, float dt) {
+    sim_thread_push_input(al->sim, process_keyboard_events_the_right_way(&al));
+    if (atomic_load(&al->sim->finished)) {
+        // the replay is over.
+        al->done = true;
+        return;
+    }
+    bool fresh;
+    double time;
+    Snapshot* snapshot = sim_thread_latest(al->sim, &fresh, &time);
+    if (fresh) {
+        uint64_t t = trace_begin();
+        snapshot_restore(snapshot, view);
+        trace_end("snapshot_restore", t);
+    }
+    // a step behind the sim: from its previous step to its last one, as far as the time since the last one.
+    float alpha = (float)((al_get_time() - time) / dt);
+    alpha = alpha < 0 ? 0 : (alpha > 1 ? 1 : alpha);
+    draw_everything(al, view, alpha);
+}
+
+/*
+ Headless run: no display, no timer, no input. Sim steps back to back as fast as it goes, each one drawn to the null renderer, so what would be drawn is counted.
+ */
+static void run_headless(OUR_AL_INSTANCE *al, GAME_INSTANCE *game, GameConfig *config) {
+    float dt = config_sim_dt(config);
+    double start = al_get_time();
+    // a replay runs till it ends, --steps doesn't apply.
+    bool replaying = al->replay->mode == REPLAY_PLAY;
+    for (long step = 0; (replaying || step < config->headless_steps) && !al->done; step++) {
+        run_one_sim_step(al, game, dt);
+        if (al->done) {
+            break;  // replay is over.
+        }
+        draw_everything(al, game, 1.0);
+    }
+    double seconds = al_get_time() - start;
+    printf("headless: %ld sim steps in %.3f s, %.0f steps/s\n", al->sim_steps, seconds, seconds > 0 ? al->sim_steps / seconds : 0);
 }
 
 int main(int argc, char **argv)
 {
+    // Settings, defaults then command line.
+    GameConfig config;
+    config_init(&config);
+    config_parse_args(&config, argc, argv);
+    
+    // A replay brings its own seed, sim rate and weapon, or the game won't be the same.
+    Replay* replay = malloc(sizeof(Replay));
+    replay_init(replay);
+    if (config.replay_path) {
+        replay_start_playing(replay, config.replay_path);
+        config.seed = replay->seed;
+        config.sim_hz = replay->sim_hz;
+        config.weapon_cooldown = replay->weapon_cooldown;
+        config.blast_lifetime = replay->blast_lifetime;
+    }
+    float dt = config_sim_dt(&config);
+    if (config.seed == 0) {
+        config.seed = (uint64_t)time(NULL);
+    }
+    if (config.record_path) {
+        if (config.replay_path) {
+            printf("can't record while playing a replay, --record ignored.\n");
+        }
+        else {
+            replay_start_recording(replay, config.record_path, config.seed, config.sim_hz, config.weapon_cooldown, config.blast_lifetime);
+        }
+    }
+    if (config.trace_path) {
+        trace_init(TRACE_EVENTS);
+    }
+    if (config.stats) {
+        printf("seed: %llu, play it again with --seed=%llu\n", (unsigned long long)config.seed, (unsigned long long)config.seed);
+    }
+    
     // Init allegro
     OUR_AL_INSTANCE* al = malloc(sizeof(OUR_AL_INSTANCE));
-    our_al_instance_init(al);
+    our_al_instance_init(al, &config);
+    al->replay = replay;
     
     // Init our game "Instance".
     GAME_INSTANCE* game = malloc(sizeof(GAME_INSTANCE));
-    game_instance_init(game);
+    game_instance_init(game, config.seed, config.threads, config.weapon_cooldown, config.blast_lifetime);
     
-    // Main loop begin, start the timer.
-    al_start_timer(al->timer);
-    while(1)
+    // the render thread's copy of the world, when the sim has its own thread.
+    GAME_INSTANCE* view = NULL;
+    
+    if (config.headless) {
+        if (config.threaded) {
+            printf("headless runs the sim back to back, --threaded ignored.\n");
+        }
+        run_headless(al, game, &config);
+        al->done = true;
+    }
+    else if (config.threaded) {
+        view = malloc(sizeof(GAME_INSTANCE));
+        game_instance_init(view, config.seed, 1, config.weapon_cooldown, config.blast_lifetime);
+        al->sim = malloc(sizeof(SimThread));
+        sim_thread_start(al->sim, game, replay, dt);
+        al_start_timer(al->timer);
+    }
+    else {
+        // Main loop begin, start the timer and the sim clock.
+        al_start_timer(al->timer);
+        al->last_time = al_get_time();
+    }
+    while(!al->done)
     {
         al_wait_for_event(al->queue, &(al->event));
 
@@ -330,9 +384,7 @@ int main(int argc, char **argv)
         switch((al->event).type)
         {
             case ALLEGRO_EVENT_TIMER:
-                /* Timer tick, process the processed keyboard events, then re-draw */
-                // Translated keyboard events to move spaceship and open fire.
-                process_keyboard_events_the_right_way(&al, game);
+                /* Timer tick, time for a new frame, keyboard is processed by the sim steps before it */
                 al->redraw = true;  // re-draw each timer event.
                 
                 break;
@@ -340,6 +392,10 @@ int main(int argc, char **argv)
             case ALLEGRO_EVENT_KEY_DOWN:
                 /* Raw keyboard events input */
                 al->key[al->event.keyboard.keycode] = KEY_SEEN | KEY_RELEASED;
+                // F12 dumps the trace so far, the game goes on.
+                if (al->event.keyboard.keycode == ALLEGRO_KEY_F12 && config.trace_path) {
+                    trace_write_json(config.trace_path);
+                }
                 // key down, set it to 00000011, both seen, and released.
                 // until next timer, assume it's still not released. Under this situation, if KEY_UP happens, 00000011 & 00000010 = 00000010,
                 // so even if it's a very quick press-release, within the gap between 1/30 seconds, next draw will still recognize this key-press. Or a very quick key-press will be omitted if it happenly happened between two draw.
@@ -367,15 +423,53 @@ int main(int argc, char **argv)
         /* Run game logic and draw when timer ticks */
         if(al->redraw && al_is_event_queue_empty(al->queue))
         {
-            /* Each frame/timer-tick, do these 4 things: */
-            run_game_logic(game);  // 1. run game logic, collision detection, win/lose are judged here.
-            update_and_move(game);  // 2. update every moving things, asteroids, blast, spaceship, all what they should be to next moment.
-            draw_everything_to_buffer(al, game);    // 3. draw everything on the buffer, buffer is used to scale later, for better support of high resolution.
-            draw_buffer_to_screen(al);  // 4. draw buffer to actual screen, with proper scale, everything just drawn shows on screen.
+            if (al->sim) {
+                // the sim steps on its own thread, only input and drawing here.
+                run_threaded_frame(al, view, dt);
+            }
+            else {
+                /* Each frame/timer-tick, do these 2 things: */
+                float alpha = advance_sim_clock(al, game, dt);  // 1. catch the sim up with real time, 0 or more fixed steps.
+                draw_everything(al, game, alpha);    // 2. draw everything, in between the last two sim steps, on the buffer, then scale it to the screen.
+            }
             al->redraw = false;     // do not re-draw untill next timer tick.
         }
     }
 
+    // the game is main thread's again after this.
+    if (al->sim) {
+        sim_thread_stop(al->sim);
+        al->sim_steps = atomic_load(&al->sim->sim_steps);
+    }
+    
+    // how big the clusters have ever grown, and how often they had to go to the heap for it.
+    if (config.stats) {
+        printf("sim steps: %ld at %.0f Hz, frames drawn: %ld at %.0f Hz\n", al->sim_steps, config.sim_hz, al->renderer->total.frames, config.render_hz);
+        asteroid_cluster_print_stats(game->all_asteroids);
+        blastcluster_print_stats(game->all_blasts);
+        weapon_print_stats(game->weapon);
+        grid_print_stats(game->grid, "blast-asteroid");
+        command_buffer_print_stats(&game->blast_commands, "blast");
+        command_buffer_print_stats(&game->asteroid_commands, "asteroid");
+        particle_pool_print_stats(game->particles);
+        renderer_print_stats(al->renderer);
+        replay_print_stats(al->replay);
+        printf("bounding box kernel: %s\n", aabb_batch_kernel_name());
+        worker_pool_print_stats(game->workers);
+        if (al->sim) {
+            sim_thread_print_stats(al->sim);
+        }
+        trace_print_stats();
+    }
+    if (config.trace_path) {
+        trace_write_json(config.trace_path);
+        trace_destroy();
+    }
+
+    if (al->sim) {
+        sim_thread_destroy(al->sim);
+        game_instance_destroy(view);
+    }
     our_al_instance_destroy(al);
     game_instance_destroy(game);
 
@@ -7,6 +7,7 @@
 //
 
 #include "collision.h"
+#include <string.h>
 
 
 /*
@@ -25,41 +26,61 @@ typedef struct {
 
 // Note: return _BBOX as value, so in function calls it will be passed by value-in-copy, so that there's no memory management problem.
 
-_BBOX _BBOX_from_spaceship(Spaceship* ship)
+// the ship caches its box, an asteroid's is worked out from x, y and scale, it's not stored.
+
+_BBOX _BBOX_from_asteroid(AsteroidCluster* ac, int i)
 {
-    // a spaceship takes a space of -8 to +8 in x, -11 to 9 in y, relative to it's x,y
-    // rotation is too complicated, use simple way instead.
-    float offset = 11 * ship->scale;  // when scale, BBOX should apply this scale.
-    _BBOX bbox = {
-        .v1_x = ship->x-offset, .v1_y = ship->y-offset,  // (-8,-11)
-        .v2_x = ship->x+offset, .v2_y = ship->y+offset,  // (+8, -11)
-    };
+    float offset = ASTEROID_BBOX_HALF * ac->scale[i];  // when scale, BBOX should apply this scale.
+    _BBOX bbox = { ac->x[i] - offset, ac->y[i] - offset, ac->x[i] + offset, ac->y[i] + offset };
     return bbox;
 }
 
-_BBOX _BBOX_from_asteroid(Asteroid* the_asteroid)
+/*
+ The segment a blast has swept through since last tick.
+ 
+ A blast is a dash from its x,y to its tip, BLAST_LENGTH ahead along the heading, and it always moves along its heading.
+ So what it has covered from last tick to now is one longer dash: from where it was last tick (prev x,y) to where its tip is now.
+ Testing this segment instead of the dash itself, a fast blast can't jump over a small asteroid between two ticks.
+ */
+typedef struct {
+    float x0, y0;   // the tail, last tick.
+    float x1, y1;   // the tip, now.
+} _SEGMENT;
+
+_SEGMENT _SEGMENT_from_blast(Blast* the_blast)
 {
-    // an asteroid takes up a space of -25 to 20 in x, -20 to 20 in y, relative to it's x,y
-    // rotation... for anoter day...
-    float offset = 25 * the_asteroid->scale;  // when scale, BBOX should apply this scale.
-    _BBOX bbox = {
-        .v1_x = the_asteroid->x-offset, .v1_y = the_asteroid->y-offset,  // (-25,-20)
-        .v2_x = the_asteroid->x+offset, .v2_y = the_asteroid->y+offset,  // (+20, -20)
-    };
-    return bbox;
+    // the tip is along the velocity, no trig here.
+    _SEGMENT segment = { .x0 = the_blast->prev_x, .y0 = the_blast->prev_y };
+    blast_tip(the_blast, &segment.x1, &segment.y1);
+    return segment;
 }
 
-_BBOX _BBOX_from_blast(Blast* the_blast)
+/*
+ Does the segment pass through the box, slab test.
+ 
+ Clip the segment's parameter range [0,1] by the x slab, then the y slab, if anything is left, it's inside the box somewhere. Touching counts, same as the box test.
+ */
+bool _SEGMENT_collide_BBOX_or_not(_SEGMENT segment, _BBOX bbox)
 {
-    // The bounding box of a blast is the rectangle of it. left-top point is v1, right-bottom point is v2.
-    // v1 with both less x and y, v2 with both greater x and y.
-    // 0 degree is defined as north, which is opposite to our screen cordinates's y, so -cos(heading) to get the other end of the blast.
-    float v1_x = the_blast->x < (the_blast->x + sin(DEGTORAD(the_blast->heading))*BLAST_LENGTH) ? the_blast->x : (the_blast->x + sin(DEGTORAD(the_blast->heading))*BLAST_LENGTH);
-    float v1_y = the_blast->y < (the_blast->y - cos(DEGTORAD(the_blast->heading))*BLAST_LENGTH) ? the_blast->y : (the_blast->y - cos(DEGTORAD(the_blast->heading))*BLAST_LENGTH);
-    float v2_x = the_blast->x > (the_blast->x + sin(DEGTORAD(the_blast->heading))*BLAST_LENGTH) ? the_blast->x : (the_blast->x + sin(DEGTORAD(the_blast->heading))*BLAST_LENGTH);
-    float v2_y = the_blast->y > (the_blast->y - cos(DEGTORAD(the_blast->heading))*BLAST_LENGTH) ? the_blast->y : (the_blast->y - cos(DEGTORAD(the_blast->heading))*BLAST_LENGTH);
-    _BBOX bbox = { v1_x, v1_y, v2_x, v2_y };
-    return bbox;
+    float t_enter = 0.0f, t_leave = 1.0f;
+    float origin[2] = { segment.x0, segment.y0 };
+    float delta[2] = { segment.x1 - segment.x0, segment.y1 - segment.y0 };
+    float slab_min[2] = { bbox.v1_x, bbox.v1_y };
+    float slab_max[2] = { bbox.v2_x, bbox.v2_y };
+    for (int axis = 0; axis < 2; axis++) {
+        if (delta[axis] == 0.0f) {
+            // parallel to this slab, it's either always in or always out.
+            if (origin[axis] < slab_min[axis] || origin[axis] > slab_max[axis]) return false;
+            continue;
+        }
+        float t0 = (slab_min[axis] - origin[axis]) / delta[axis];
+        float t1 = (slab_max[axis] - origin[axis]) / delta[axis];
+        if (t0 > t1) { float t = t0; t0 = t1; t1 = t; }
+        if (t0 > t_enter) t_enter = t0;
+        if (t1 < t_leave) t_leave = t1;
+        if (t_enter > t_leave) return false;
+    }
+    return true;
 }
 
 /*
@@ -77,82 +98,235 @@ bool _BBOX_collide_or_not(_BBOX bbox1, _BBOX bbox2)
     return true;
 }
 
-bool is_asteroid_hit_spaceship_yn(Spaceship* ship, Asteroid* asteroid)
+
+// 1 for crash, 0 for not crash.
+int ship_crash_detection(AsteroidCluster* all_asteroids, Spaceship* ship, SweepAndPrune* sap)
 {
-    return _BBOX_collide_or_not(_BBOX_from_asteroid(asteroid), _BBOX_from_spaceship(ship));
+    // If ship is in it's invicible time, it will not crash.
+    if (ship->invincible_time) {
+        return 0;
+    }
+    // Ship is item 0, asteroid i is item i+1, the sweep sees the screen edges as joined.
+    sweep_set_item_count(sap, all_asteroids->count + 1);
+    sap->min_x[0] = ship->min_x;
+    sap->min_y[0] = ship->min_y;
+    sap->max_x[0] = ship->max_x;
+    sap->max_y[0] = ship->max_y;
+    // the asteroids' boxes from x, y and scale, one pass over the hot arrays.
+    for (int i = 0; i < all_asteroids->count; i++) {
+        float offset = ASTEROID_BBOX_HALF * all_asteroids->scale[i];
+        sap->min_x[i + 1] = all_asteroids->x[i] - offset;
+        sap->min_y[i + 1] = all_asteroids->y[i] - offset;
+        sap->max_x[i + 1] = all_asteroids->x[i] + offset;
+        sap->max_y[i + 1] = all_asteroids->y[i] + offset;
+    }
+    sweep_update(sap);
+    
+    // Check if spaceship doesn't crash at any asteroid.
+    if (sweep_pairs_with_item(sap, 0)) {
+        spaceship_just_hit(ship);
+        /*
+         main game logic should not implemented here, it should goes to main.
+         */
+        return 1; // for crash.
+    }
+    return 0;
 }
 
-bool is_blast_hit_asteroid_yn(Blast* blast, Asteroid* asteroid)
+int hit_events_init(HitEvents* hits, int buffer_count)
 {
-    return _BBOX_collide_or_not(_BBOX_from_asteroid(asteroid), _BBOX_from_blast(blast));
+    hits->buffers = calloc(buffer_count, sizeof(HitEventBuffer));
+    if (!hits->buffers) {
+        go_error("Failed when allocating hit event buffers, out of memory.");
+    }
+    hits->buffer_count = buffer_count;
+    hits->merged = NULL;
+    hits->merged_capacity = 0;
+    hits->segments = NULL;
+    hits->segment_capacity = 0;
+    hits->blast_used = NULL;
+    hits->blast_used_capacity = 0;
+    hits->asteroid_hit = NULL;
+    hits->asteroid_capacity = 0;
+    return 0;
 }
 
-// 1 for crash, 0 for not crash.
-int ship_crash_detection(AsteroidCluster* all_asteroids, Spaceship* ship)
+int hit_events_destroy(HitEvents* hits)
 {
-    // If ship is in it's invicible time, it will not crash.
-    if (ship->invincible_time) {
-        return 0;
+    for (int w = 0; w < hits->buffer_count; w++) {
+        free(hits->buffers[w].events);
+        free(hits->buffers[w].query_results);
+        free(hits->buffers[w].hit_masks);
     }
-    // Check if spaceship doesn't crash at every asteroids.
-    AsteroidClusterNode* asteroid_iterator = all_asteroids->first_node;
-    // loop till it's NULL
-    while (asteroid_iterator) {
-        if (is_asteroid_hit_spaceship_yn(ship, asteroid_iterator->real_instance)) {
-            spaceship_just_hit(ship);
-            /*
-             main game logic should not implemented here, it should goes to main.
-             */
-            return 1; // for crash.
+    free(hits->buffers);
+    free(hits->merged);
+    free(hits->segments);
+    free(hits->blast_used);
+    free(hits->asteroid_hit);
+    free(hits);
+    return 0;
+}
+
+/*
+ Make sure there's room for count elements of size in *array, doubling from 64, what's in it is kept.
+ */
+void _hit_events_reserve(void** array, int* capacity, int count, size_t size)
+{
+    if (count <= *capacity) {
+        return;
+    }
+    int new_capacity = *capacity ? *capacity : 64;
+    while (new_capacity < count) {
+        new_capacity *= 2;
+    }
+    *array = must_realloc(*array, new_capacity * size, "Failed when growing hit events, out of memory.");
+    *capacity = new_capacity;
+}
+
+typedef struct {
+    AsteroidCluster* asteroids;
+    BlastCluster* blasts;
+    BroadphaseGrid* grid;
+    HitEvents* hits;
+} HitDetectionTask;
+
+/*
+ Detect phase of asteroids [begin, end), on worker's buffer. Reads the clusters and the grid, writes only the buffer.
+ */
+void _hit_detection_range(void* context, int worker, int begin, int end)
+{
+    HitDetectionTask* task = context;
+    AsteroidCluster* ac = task->asteroids;
+    HitEventBuffer* buffer = &task->hits->buffers[worker];
+    for (int i = begin; i < end; i++) {
+        _BBOX bbox = _BBOX_from_asteroid(ac, i);
+        int found = grid_query_into(task->grid, bbox.v1_x, bbox.v1_y, bbox.v2_x, bbox.v2_y, buffer->query_results, buffer->hit_masks, &buffer->tested);
+        buffer->overlapped += found;
+        for (int k = 0; k < found; k++) {
+            int b = buffer->query_results[k];
+            // swept test: what the blast has passed through since last tick, not only where it is now.
+            float* s = &task->hits->segments[b * 4];
+            _SEGMENT segment = { s[0], s[1], s[2], s[3] };
+            if (!_SEGMENT_collide_BBOX_or_not(segment, bbox)) {
+                continue;
+            }
+            _hit_events_reserve((void**)&buffer->events, &buffer->capacity, buffer->count + 1, sizeof(HitEvent));
+            HitEvent* event = &buffer->events[buffer->count++];
+            event->blast_id = blastcluster_handle(task->blasts, b);
+            event->asteroid_id = asteroid_cluster_handle(ac, i);
+            event->blast = b;
+            event->asteroid = i;
         }
-        asteroid_iterator = asteroid_iterator->next;
+    }
+}
+
+/*
+ By handle, blast first, then asteroid, no two events are the same pair.
+ */
+int _hit_event_compare(const void* a, const void* b)
+{
+    const HitEvent* event_a = a;
+    const HitEvent* event_b = b;
+    if (event_a->blast_id != event_b->blast_id) {
+        return event_a->blast_id < event_b->blast_id ? -1 : 1;
+    }
+    if (event_a->asteroid_id != event_b->asteroid_id) {
+        return event_a->asteroid_id < event_b->asteroid_id ? -1 : 1;
     }
     return 0;
 }
 
-int asteroid_hit_detection(AsteroidCluster* all_asteroids, BlastCluster* all_blasts)
+int asteroid_hit_detection(AsteroidCluster* all_asteroids, BlastCluster* all_blasts, BroadphaseGrid* grid, HitEvents* hits, WorkerPool* workers, CommandBuffer* blast_commands, CommandBuffer* asteroid_commands, ParticlePool* particles)
 {
     /*
      Check for all blasts and all asteroids, if any of them collides, score a point.
      After checking, return total score earned in this round.
+     
+     Broadphase: blasts are put in a grid, each asteroid only tests the blasts sharing a cell with it.
+     Narrow phase: the segment the blast swept since last tick against the asteroid's box, so nothing is missed even when a blast moves further than an asteroid's size in one tick.
+     A blast hits at most one asteroid, an asteroid gets hit at most once in a round, asteroids split in this round are checked next round.
      */
     int score_increment = 0;
-    bool hit_flag = false;
-    AsteroidClusterNode* asteroid_iterator = all_asteroids->first_node;
-    while (asteroid_iterator) {
-        BlastClusterNode* blast_iterator = all_blasts->first_node;
-        while (blast_iterator) {
-            if (is_blast_hit_asteroid_yn(blast_iterator->real_instance, asteroid_iterator->real_instance)) {
-                
-                // 1. increase the score, by step.
-                score_increment += SCORE_STEP;
-                
-                // 2. asteroid got hit and split, one asteroid could only get hit once, so go on to next one.
-                // there's a chance it will be deleted, so before remove current node, save the next one's link.
-                AsteroidClusterNode* new_asteroid_iterator = asteroid_iterator->next;   // NULL is fine, while check will handle it.
-                asteroid_hit_and_split(all_asteroids, asteroid_iterator->real_instance);
-                asteroid_iterator = new_asteroid_iterator;
-                // set hit flag, so in the outer while, it will not move to next (here already moved)
-                hit_flag = true;
-                
-                // 3. remove the blast just hit, this round will not continue, it's OK.
-                blastcluster_remove_node(all_blasts, blast_iterator);   // link between side is implemented in the cluseter remove node function.
-                blast_iterator = NULL; // this will automatically break the inner while.
-            }
-            else {
-                blast_iterator = blast_iterator->next;
-            }
-        }
-        // check if in the inner while there's a hit
-        if (hit_flag) {
-            // no need to move the cursor forward, already points to next element.
-            // set flag back to false.
-            hit_flag = !hit_flag;
+    
+    // 1. flatten the blast ring, a blast is its order in it from now on, and rebuild the grid from blasts' swept boxes.
+    int blast_count = all_blasts->count;
+    int asteroid_count = all_asteroids->count;
+    if (blast_count == 0 || asteroid_count == 0) {
+        return 0;
+    }
+    _hit_events_reserve((void**)&hits->segments, &hits->segment_capacity, blast_count, 4 * sizeof(float));
+    _hit_events_reserve((void**)&hits->blast_used, &hits->blast_used_capacity, blast_count, sizeof(unsigned char));
+    grid_set_item_count(grid, blast_count);
+    int b;
+    for (b = 0; b < blast_count; b++) {
+        // the swept segment once per blast, its box goes into the grid.
+        _SEGMENT segment = _SEGMENT_from_blast(blastcluster_at(all_blasts, b));
+        float* s = &hits->segments[b * 4];
+        s[0] = segment.x0; s[1] = segment.y0; s[2] = segment.x1; s[3] = segment.y1;
+        grid->min_x[b] = segment.x0 < segment.x1 ? segment.x0 : segment.x1;
+        grid->min_y[b] = segment.y0 < segment.y1 ? segment.y0 : segment.y1;
+        grid->max_x[b] = segment.x0 > segment.x1 ? segment.x0 : segment.x1;
+        grid->max_y[b] = segment.y0 > segment.y1 ? segment.y0 : segment.y1;
+    }
+    grid_build(grid);
+    
+    // 2. detect, each worker over its part of the asteroids. Scratch is sized here, nothing shared grows while they run.
+    for (int w = 0; w < hits->buffer_count; w++) {
+        HitEventBuffer* buffer = &hits->buffers[w];
+        buffer->count = 0;
+        buffer->tested = 0;
+        buffer->overlapped = 0;
+        _hit_events_reserve((void**)&buffer->query_results, &buffer->query_capacity, blast_count, sizeof(int));
+        _hit_events_reserve((void**)&buffer->hit_masks, &buffer->mask_capacity, grid->entry_count / 32 + 1, sizeof(uint32_t));
+    }
+    HitDetectionTask task = { all_asteroids, all_blasts, grid, hits };
+    worker_pool_run(workers, _hit_detection_range, &task, asteroid_count, ASTEROID_PARALLEL_MIN);
+    
+    // 3. merge and sort, so which worker found what doesn't matter.
+    // the grid's counters mean what grid_query() counts: boxes tested, and of them the ones that overlapped.
+    int event_count = 0;
+    long tested = 0;
+    long overlapped = 0;
+    for (int w = 0; w < hits->buffer_count; w++) {
+        event_count += hits->buffers[w].count;
+        tested += hits->buffers[w].tested;
+        overlapped += hits->buffers[w].overlapped;
+    }
+    grid->pairs_tested += tested;
+    grid->pairs_hit += overlapped;
+    grid->total_pairs_tested += tested;
+    grid->total_pairs_hit += overlapped;
+    if (event_count == 0) {
+        return 0;
+    }
+    _hit_events_reserve((void**)&hits->merged, &hits->merged_capacity, event_count, sizeof(HitEvent));
+    int merged = 0;
+    for (int w = 0; w < hits->buffer_count; w++) {
+        // a worker that never found anything has no events array yet.
+        if (hits->buffers[w].count == 0) {
+            continue;
         }
-        else {
-            // not hit, have to move the cursor forward.
-            asteroid_iterator = asteroid_iterator->next; // NULL will be handled by while check.
+        memcpy(hits->merged + merged, hits->buffers[w].events, hits->buffers[w].count * sizeof(HitEvent));
+        merged += hits->buffers[w].count;
+    }
+    qsort(hits->merged, event_count, sizeof(HitEvent), _hit_event_compare);
+    
+    // 4. resolve, in handle order each blast takes the first asteroid not hit yet. What a hit does is recorded in the same order, nothing in the clusters moves, the caller applies it.
+    _hit_events_reserve((void**)&hits->asteroid_hit, &hits->asteroid_capacity, asteroid_count, sizeof(unsigned char));
+    memset(hits->blast_used, 0, blast_count * sizeof(unsigned char));
+    memset(hits->asteroid_hit, 0, asteroid_count * sizeof(unsigned char));
+    for (int e = 0; e < event_count; e++) {
+        HitEvent* event = &hits->merged[e];
+        if (hits->blast_used[event->blast] || hits->asteroid_hit[event->asteroid]) {
+            continue;
         }
+        hits->blast_used[event->blast] = 1;
+        hits->asteroid_hit[event->asteroid] = 1;
+        // the blast is done, the asteroid splits or blows up.
+        command_buffer_record_remove(blast_commands, event->blast_id);
+        asteroid_hit(all_asteroids, event->asteroid_id, asteroid_commands, particles);
+        // increase the score, by step.
+        score_increment += SCORE_STEP;
     }
     return score_increment; // the socre earned in this round will be returned.
 }
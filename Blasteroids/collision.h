@@ -21,22 +21,86 @@
 #include "blast.h"
 #include "lifecounter.h"
 #include "score.h"
+#include "grid.h"
+#include "sweep.h"
+#include "worker_pool.h"
+
+/*
+ Asteroid's box met blast's swept segment.
+ 
+ Who they are is their handles (handle.h), they don't change while the entities live, wherever the clusters move them, so resolve goes by them.
+ Where they are this tick is the index, for the per tick marks, nothing moves until resolve is done.
+ */
+typedef struct {
+    Handle blast_id;
+    Handle asteroid_id;
+    int blast;      // order in the blast ring this tick, oldest first.
+    int asteroid;   // index in the cluster this tick.
+} HitEvent;
+
+/*
+ Events found by one worker, and its own query scratch, so workers never write the same memory.
+ */
+typedef struct {
+    HitEvent* events;
+    int count;
+    int capacity;
+    int* query_results;
+    uint32_t* hit_masks;
+    int query_capacity;
+    int mask_capacity;
+    long tested;    // boxes tested by the grid queries.
+    long overlapped;    // of them, how many overlapped the asteroid's box, before the swept test.
+} HitEventBuffer;
+
+/*
+ Everything hit detection needs besides the clusters and the grid, it only grows, after a few ticks there's no more heap calls.
+ */
+typedef struct {
+    HitEventBuffer* buffers;    // one per worker thread.
+    int buffer_count;
+    HitEvent* merged;   // all buffers together, sorted for resolve.
+    int merged_capacity;
+    // the swept segment of each blast in the ring, x0, y0, x1, y1, indexed by HitEvent.blast.
+    float* segments;
+    int segment_capacity;   // in blasts.
+    unsigned char* blast_used;
+    int blast_used_capacity;
+    unsigned char* asteroid_hit;
+    int asteroid_capacity;
+} HitEvents;
+
+/*
+ buffer_count: how many worker threads could run detection.
+ */
+int hit_events_init(HitEvents* hits, int buffer_count);
+
+int hit_events_destroy(HitEvents* hits);
 
 /*
  Ship hit by asteroids.
  
  If crash, return 1, else, return 0.
+ 
+ sap is the broadphase, it's kept across calls. The screen wraps, an asteroid sticking out of one edge can hit the ship at the other edge.
  */
-int ship_crash_detection(AsteroidCluster* all_asteroids, Spaceship* ship);
+int ship_crash_detection(AsteroidCluster* all_asteroids, Spaceship* ship, SweepAndPrune* sap);
 
 /*
  Asteroids hit by blasts.
  
  If no hit, return 0, else, return the score.
  
- Asteroids and blasts that are hit will get destroyed.
- (optional, later) a explosion VFX will be added where the asteroid is hit.
+ Asteroids and blasts that are hit will get destroyed, the asteroids destroyed blow up into particles (could be NULL).
+ Nothing is removed or spawned here, it's recorded into blast_commands and asteroid_commands, the caller applies them at the end of its stage (blastcluster_apply(), asteroid_cluster_apply()).
+ 
+ Two phases:
+    detect  -- read only. The asteroids are split across the workers, each one queries grid for the blasts around its asteroids, and writes every (blast, asteroid) pair that met into its own buffer.
+    resolve -- on the caller. All events are sorted by blast handle then asteroid handle, walked in that order, a blast takes the first asteroid not hit yet. What each hit does, the blast's remove and the asteroid's split or remove, is recorded in that order too.
+ The sort makes the outcome independent of how the asteroids were split across threads, and of where the clusters keep them: the same with any number of threads, the same if storage is reordered.
+ 
+ grid is the broadphase, it's rebuilt from the blasts on every call, its counters tell how many pairs are tested and how many of their boxes overlapped, the same as grid_query() counts them. Actual hits are the score.
  */
-int asteroid_hit_detection(AsteroidCluster* all_asteroids, BlastCluster* all_blasts);
+int asteroid_hit_detection(AsteroidCluster* all_asteroids, BlastCluster* all_blasts, BroadphaseGrid* grid, HitEvents* hits, WorkerPool* workers, CommandBuffer* blast_commands, CommandBuffer* asteroid_commands, ParticlePool* particles);
 
 #endif /* collision_h */
@@ -0,0 +1,90 @@
+//
+//  command_buffer.c
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/11.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+#include "common.h"
+#include "command_buffer.h"
+#include <string.h>
+
+int command_buffer_init(CommandBuffer* buffer)
+{
+    buffer->commands = NULL;
+    buffer->count = 0;
+    buffer->capacity = 0;
+    buffer->spawn_data = NULL;
+    buffer->spawn_size = 0;
+    buffer->spawn_capacity = 0;
+    buffer->recorded = 0;
+    buffer->applied = 0;
+    buffer->stale = 0;
+    return 0;
+}
+
+int command_buffer_release(CommandBuffer* buffer)
+{
+    free(buffer->commands);
+    free(buffer->spawn_data);
+    return 0;
+}
+
+Command* _command_buffer_append(CommandBuffer* buffer, CommandType type, Handle target)
+{
+    if (buffer->count == buffer->capacity) {
+        int capacity = buffer->capacity ? buffer->capacity * 2 : 64;
+        buffer->commands = must_realloc(buffer->commands, (size_t)capacity * sizeof(Command), "Failed when growing command buffer, out of memory.");
+        buffer->capacity = capacity;
+    }
+    Command* command = &buffer->commands[buffer->count++];
+    command->target = target;
+    command->type = type;
+    command->spawn = -1;
+    buffer->recorded++;
+    return command;
+}
+
+int command_buffer_record_remove(CommandBuffer* buffer, Handle target)
+{
+    _command_buffer_append(buffer, COMMAND_REMOVE, target);
+    return 0;
+}
+
+int command_buffer_record_spawn(CommandBuffer* buffer, const void* data, size_t size)
+{
+    // rounded up to 8 bytes, so every spawn's data is aligned for whatever it holds.
+    size_t padded = (size + 7) & ~(size_t)7;
+    if (buffer->spawn_size + padded > buffer->spawn_capacity) {
+        size_t capacity = buffer->spawn_capacity ? buffer->spawn_capacity : 1024;
+        while (capacity < buffer->spawn_size + padded) {
+            capacity *= 2;
+        }
+        buffer->spawn_data = must_realloc(buffer->spawn_data, capacity, "Failed when growing command buffer, out of memory.");
+        buffer->spawn_capacity = capacity;
+    }
+    Command* command = _command_buffer_append(buffer, COMMAND_SPAWN, HANDLE_NONE);
+    command->spawn = (int)buffer->spawn_size;
+    memcpy(buffer->spawn_data + buffer->spawn_size, data, size);
+    buffer->spawn_size += padded;
+    return 0;
+}
+
+void* command_buffer_spawn_data(CommandBuffer* buffer, Command* command)
+{
+    return buffer->spawn_data + command->spawn;
+}
+
+int command_buffer_clear(CommandBuffer* buffer)
+{
+    buffer->count = 0;
+    buffer->spawn_size = 0;
+    return 0;
+}
+
+int command_buffer_print_stats(CommandBuffer* buffer, const char* name)
+{
+    printf("%s commands: recorded %ld, applied %ld, stale %ld\n", name, buffer->recorded, buffer->applied, buffer->stale);
+    return 0;
+}
@@ -0,0 +1,80 @@
+//
+//  command_buffer.h
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/11.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+/*
+ Command buffer, what a stage wants done to a cluster, kept until the stage is over.
+ 
+ A stage never removes or spawns anything in a cluster while it goes, it records a command instead. At the end of the stage the cluster applies them all at once (asteroid_cluster_apply(), blastcluster_apply()), then the buffer is empty again for the next stage.
+ So nothing moves under a loop, it needs no care for what a remove or a spawn did to the indices, and a stage run by workers could record into a buffer per worker.
+ The game has one buffer per cluster, a stage applies them at its end: run_game_logic() for fire and hits, update_and_move() for blasts that flew too far or too long (game.c).
+ 
+ Commands:
+    remove -- the entity, by handle (handle.h), is gone. A remove on one that's gone already (say, hit twice) is skipped, counted as stale.
+    spawn  -- a new entity, what it is is up to the cluster (AsteroidSpawn, BlastSpawn), copied into the buffer when recorded.
+ In what order they apply is up to the cluster, always the same for the same commands, so the same game.
+ 
+ It only grows, after a few ticks recording is no heap call.
+ */
+
+#ifndef command_buffer_h
+#define command_buffer_h
+
+#include <stdio.h>
+#include "handle.h"
+
+typedef enum {
+    COMMAND_REMOVE,
+    COMMAND_SPAWN
+} CommandType;
+
+typedef struct {
+    Handle target;  // remove: who, spawn: HANDLE_NONE.
+    int type;   // CommandType
+    int spawn;  // spawn: where its data is in the buffer's spawn data.
+} Command;
+
+typedef struct {
+    Command* commands;
+    int count;
+    int capacity;
+    unsigned char* spawn_data;  // what each spawn is, one after another.
+    size_t spawn_size;
+    size_t spawn_capacity;
+    long recorded;
+    long applied;
+    long stale;     // target was gone when applied.
+} CommandBuffer;
+
+/*
+ An empty buffer, it's part of something else, it's not allocated here.
+ */
+int command_buffer_init(CommandBuffer* buffer);
+
+/*
+ Free the commands, not the buffer.
+ */
+int command_buffer_release(CommandBuffer* buffer);
+
+int command_buffer_record_remove(CommandBuffer* buffer, Handle target);
+
+/*
+ Copy size bytes of data as a spawn, the cluster reads it back with command_buffer_spawn_data().
+ */
+int command_buffer_record_spawn(CommandBuffer* buffer, const void* data, size_t size);
+
+void* command_buffer_spawn_data(CommandBuffer* buffer, Command* command);
+
+/*
+ All applied, empty it for the next stage.
+ */
+int command_buffer_clear(CommandBuffer* buffer);
+
+int command_buffer_print_stats(CommandBuffer* buffer, const char* name);
+
+
+#endif /* command_buffer_h */
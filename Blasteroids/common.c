@@ -7,15 +7,33 @@
 //
 
 #include "common.h"
+#include <math.h>
 
-int random_between(int lo, int hi)
+int random_between(Rng* rng, int lo, int hi)
 {
-    return lo + (rand() % (hi - lo));
+    return rng_int(rng, lo, hi);
 }
 
-float random_between_f(float lo, float hi)
+float random_between_f(Rng* rng, float lo, float hi)
 {
-    return lo + ((float)rand() / (float)RAND_MAX) * (hi - lo);
+    return rng_float(rng, lo, hi);
+}
+
+float lerp_f(float prev, float cur, float alpha)
+{
+    return prev + (cur - prev) * alpha;
+}
+
+float lerp_wrapped_f(float prev, float cur, float alpha, float period)
+{
+    float d = cur - prev;
+    if (d > period / 2) {
+        d -= period;
+    }
+    else if (d < -period / 2) {
+        d += period;
+    }
+    return prev + d * alpha;
 }
 
 int go_error(char* err_msg)
@@ -32,32 +50,41 @@ void must_init(bool test, const char *description)
     exit(1);
 }
 
-void draw_text_center_overlay(ALLEGRO_FONT* font, float pos_x, float pos_y, ALLEGRO_COLOR font_color, ALLEGRO_COLOR background_color, float scale, char* text_to_draw)
+void* must_realloc(void* block, size_t size, char* err_msg)
 {
-    
-    ALLEGRO_TRANSFORM transform;
-    al_identity_transform(&transform);
-    // which comes first which comes late matters.
-    al_scale_transform(&transform, scale, scale);   // scale-x, scale-y
-    al_translate_transform(&transform, 0, 0);   // move to position-x,y
-    al_use_transform(&transform);
-    al_draw_filled_rectangle(0,  0,  BUFFER_WIDTH,  BUFFER_HEIGHT, background_color);
-    al_translate_transform(&transform, pos_x, pos_y);
-    al_use_transform(&transform);
-    al_draw_text(font, font_color, 0, 0, ALLEGRO_ALIGN_CENTRE, text_to_draw);
+    void* grown = realloc(block, size);
+    if (!grown) {
+        go_error(err_msg);
+    }
+    return grown;
 }
 
-void draw_level_center_overlay(ALLEGRO_FONT* font, float pos_x, float pos_y, ALLEGRO_COLOR font_color, ALLEGRO_COLOR background_color, float scale, int level)
+void draw_text_center_overlay(Renderer* r, HudCache* cache, ALLEGRO_FONT* font, float pos_x, float pos_y, ALLEGRO_COLOR font_color, ALLEGRO_COLOR background_color, float scale, const char* text_to_draw)
 {
-    
     ALLEGRO_TRANSFORM transform;
-    al_identity_transform(&transform);
-    // which comes first which comes late matters.
-    al_scale_transform(&transform, scale, scale);   // scale-x, scale-y
-    al_translate_transform(&transform, 0, 0);   // move to position-x,y
-    al_use_transform(&transform);
-    al_draw_filled_rectangle(0,  0,  BUFFER_WIDTH,  BUFFER_HEIGHT, background_color);
-    al_translate_transform(&transform, pos_x, pos_y);
-    al_use_transform(&transform);
-    al_draw_textf(font, font_color, 0, 0, ALLEGRO_ALIGN_CENTRE, "LEVEL %d", level);
+    // the background covers the whole buffer, fully transparent (what every caller passes for now) is nothing to draw.
+    if (background_color.a > 0) {
+        al_identity_transform(&transform);
+        render_use_transform(r, &transform);
+        render_filled_rectangle(r, 0,  0,  BUFFER_WIDTH,  BUFFER_HEIGHT, background_color);
+    }
+    int width = (int)ceilf(al_get_text_width(font, text_to_draw) * scale);
+    int height = (int)ceilf(al_get_font_line_height(font) * scale);
+    if (hud_cache_begin(cache, r, text_to_draw, width, height)) {
+        // a new message, draw it into the cache, scaled.
+        al_identity_transform(&transform);
+        al_scale_transform(&transform, scale, scale);   // scale-x, scale-y
+        render_use_transform(r, &transform);
+        render_text(r, font, font_color, 0, 0, 0, text_to_draw);
+        hud_cache_end(cache, r);
+    }
+    // centered on pos_x, top at pos_y.
+    hud_cache_draw(cache, r, pos_x - width / 2.0f, pos_y);
+}
+
+void draw_level_center_overlay(Renderer* r, HudCache* cache, ALLEGRO_FONT* font, float pos_x, float pos_y, ALLEGRO_COLOR font_color, ALLEGRO_COLOR background_color, float scale, int level)
+{
+    char text[32];
+    snprintf(text, sizeof(text), "LEVEL %d", level);
+    draw_text_center_overlay(r, cache, font, pos_x, pos_y, font_color, background_color, scale, text);
 }
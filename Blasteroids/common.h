@@ -14,6 +14,9 @@
 #include <allegro5/allegro5.h>
 #include <allegro5/allegro_font.h>
 #include <allegro5/allegro_primitives.h>
+#include "renderer.h"
+#include "hud_cache.h"
+#include "rng.h"
 
 
 /* Helper macro, translate 0-360 degree to rad */
@@ -27,18 +30,34 @@
 #define BUFFER_WIDTH 1280
 #define BUFFER_HEIGHT 960
 
-// actual screen
-#define DISP_SCALE 2
-#define DISP_WIDTH (BUFFER_WIDTH * DISP_SCALE)
-#define DISP_HEIGHT (BUFFER_HEIGHT * DISP_SCALE)
+// actual screen is the buffer times this, can be changed from command line (--scale), see config.h.
+#define DEFAULT_DISP_SCALE 2
 
-// display frame rate (game tick)
+// sim rate (game tick) and display frame rate by default, both can be changed from command line, see config.h.
+#define DEFAULT_SIM_HZ 30
+#define DEFAULT_RENDER_HZ 60
+// the per tick settings (ANGLE_ACC, LINEAR_ACC, asteroid rotation) were tuned at this rate, they are scaled by dt * GAME_FPS so any sim rate plays the same.
 #define GAME_FPS 30
+// in seconds, a frame longer than this (window dragged, debugger...) is cut to it, so the sim doesn't spiral trying to catch up.
+#define MAX_FRAME_TIME 0.25
+// sim steps of a headless run, if not given from command line.
+#define DEFAULT_HEADLESS_STEPS 10000
+// rng seed, if not given from command line. 0 == seed from the clock.
+#define DEFAULT_SEED 0
+// threads updating the asteroids, the main one included. 1 == serial.
+#define DEFAULT_THREADS 1
 
 /* For elegant keyborad reading. */
 #define KEY_SEEN     1
 #define KEY_RELEASED 2
 
+/* Input of one tick, a mask of these, it's what a replay records. */
+#define INPUT_UP     (1 << 0)
+#define INPUT_DOWN   (1 << 1)
+#define INPUT_LEFT   (1 << 2)
+#define INPUT_RIGHT  (1 << 3)
+#define INPUT_FIRE   (1 << 4)
+
 
 /* Spaceship settings */
 
@@ -61,6 +80,8 @@
 #define LIFE_COUNTER_POSTIION_LEFT_Y 100.0
 #define LIFE_COUNTER_SCALE 1.5
 #define LIFE_COUNTER_PADDING 25.0
+// room around an indicator in the HUD cache, a ship at LIFE_COUNTER_SCALE is about 20 px from its center.
+#define LIFE_COUNTER_CACHE_MARGIN 24.0
 
 
 /* Score */
@@ -77,6 +98,14 @@
 #define BLAST_LENGTH 10
 // how wide should blast dash(line) be, in original px before scale
 #define BLAST_WIDTH 1.5
+// in px/second, by spec in the book, 3 times the max speed of a space ship.
+#define BLAST_SPEED (MAX_SPEED * 3)
+// in seconds, holding fire fires once every this long. default of --cooldown.
+#define WEAPON_COOLDOWN 0.1
+// in seconds, a blast is gone after flying this long, BLAST_LIFETIME * MAX_SPEED * 3 is how far it gets. default of --blast-life.
+#define BLAST_LIFETIME 2.0
+// fewest blasts in the ring, it's lifetime / cooldown + 1 when that's more, the most the weapon can have in the air. past it, a new one takes the place of the oldest.
+#define BLAST_CAPACITY 32
 
 
 /* Asteroid */
@@ -97,6 +126,31 @@
 #define ASTEROID_DEFAULT_SPLIT_DEGREE 45
 // after each hit, how small should the splited ones be
 #define ASTEROID_SCALE_FACTOR_WHEN_HIT 1.5
+// room of asteroid cluster when it's created, it doubles each time it's full.
+#define ASTEROID_CLUSTER_INIT_CAPACITY 64
+// fewer asteroids than this are updated serially, waking the workers costs more than it saves.
+#define ASTEROID_PARALLEL_MIN 4096
+
+
+/* Particles */
+
+// most particles alive at once, all allocated up front. past it, new ones take the place of the oldest.
+#define PARTICLE_BUDGET 4096
+// particles of an asteroid blowing up.
+#define PARTICLE_BURST 16
+// in seconds, every particle lives this long.
+#define PARTICLE_LIFETIME 0.6
+// in px/second
+#define PARTICLE_MIN_SPEED 40.0
+#define PARTICLE_MAX_SPEED 160.0
+// side of the square, in px.
+#define PARTICLE_SIZE 2.0
+
+
+/* Collision */
+
+// cell size of the broadphase grid, in px. the biggest asteroid is 150px wide, it takes at most 3x3 cells.
+#define GRID_CELL_SIZE 80.0
 
 
 /* Level */
@@ -107,6 +161,12 @@
 #define DEFAULT_WIN_COUNTDOWN 1
 
 
+/* Trace */
+
+// events the --trace ring holds, about 20 a frame, so it's the last minute or so.
+#define TRACE_EVENTS 65536
+
+
 /* DEBUG mode, show console outputs */
 
 #define VERBOSE 1
@@ -115,17 +175,33 @@
 
 /* Some helper function goes here. */
 
-int random_between(int lo, int hi);
+/*
+ Uniform in [lo, hi), from the game's own rng.
+ */
+int random_between(Rng* rng, int lo, int hi);
 
-float random_between_f(float lo, float hi);
+float random_between_f(Rng* rng, float lo, float hi);
+
+/*
+ For render interpolation, alpha 0 == prev, 1 == cur.
+ The wrapped one takes the short way around, for things that wrap at period (screen edges, 360 degree).
+ */
+float lerp_f(float prev, float cur, float alpha);
+
+float lerp_wrapped_f(float prev, float cur, float alpha, float period);
 
 int go_error(char* err_msg);
 
 void must_init(bool test, const char *description);
 
-void draw_text_center_overlay(ALLEGRO_FONT* font, float pos_x, float pos_y, ALLEGRO_COLOR font_color, ALLEGRO_COLOR background_color, float scale, char* text_to_draw);
+/*
+ realloc, block is only replaced when it worked, on failure it's go_error(err_msg) with block still good, nothing leaks.
+ */
+void* must_realloc(void* block, size_t size, char* err_msg);
+
+void draw_text_center_overlay(Renderer* r, HudCache* cache, ALLEGRO_FONT* font, float pos_x, float pos_y, ALLEGRO_COLOR font_color, ALLEGRO_COLOR background_color, float scale, const char* text_to_draw);
 
-void draw_level_center_overlay(ALLEGRO_FONT* font, float pos_x, float pos_y, ALLEGRO_COLOR font_color, ALLEGRO_COLOR background_color, float scale, int level);
+void draw_level_center_overlay(Renderer* r, HudCache* cache, ALLEGRO_FONT* font, float pos_x, float pos_y, ALLEGRO_COLOR font_color, ALLEGRO_COLOR background_color, float scale, int level);
 
 
 
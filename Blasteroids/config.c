@@ -0,0 +1,186 @@
+//
+//  config.c
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/02.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+#include "config.h"
+#include <string.h>
+
+/*
+ If arg is "name=value", parse value as a rate in Hz into out and return true.
+ */
+bool _config_parse_hz(const char* arg, const char* name, float* out)
+{
+    size_t len = strlen(name);
+    if (strncmp(arg, name, len) != 0 || arg[len] != '=') {
+        return false;
+    }
+    char* end = NULL;
+    float value = strtof(arg + len + 1, &end);
+    if (end == arg + len + 1 || *end != '\0' || value < 1 || value > 1000) {
+        printf("bad value of %s, should be 1-1000, ignored.\n", name);
+        return true;
+    }
+    *out = value;
+    return true;
+}
+
+/*
+ If arg is "name=value", parse value as a display scale into out and return true.
+ */
+bool _config_parse_scale(const char* arg, const char* name, float* out)
+{
+    size_t len = strlen(name);
+    if (strncmp(arg, name, len) != 0 || arg[len] != '=') {
+        return false;
+    }
+    char* end = NULL;
+    float value = strtof(arg + len + 1, &end);
+    if (end == arg + len + 1 || *end != '\0' || value < 0.25 || value > 8) {
+        printf("bad value of %s, should be 0.25-8, ignored.\n", name);
+        return true;
+    }
+    *out = value;
+    return true;
+}
+
+/*
+ If arg is "name=value", parse value as a time in seconds into out and return true.
+ */
+bool _config_parse_seconds(const char* arg, const char* name, float* out)
+{
+    size_t len = strlen(name);
+    if (strncmp(arg, name, len) != 0 || arg[len] != '=') {
+        return false;
+    }
+    char* end = NULL;
+    float value = strtof(arg + len + 1, &end);
+    if (end == arg + len + 1 || *end != '\0' || value < 0.01 || value > 10) {
+        printf("bad value of %s, should be 0.01-10, ignored.\n", name);
+        return true;
+    }
+    *out = value;
+    return true;
+}
+
+/*
+ If arg is "name=value", parse value as a positive count into out and return true.
+ */
+bool _config_parse_count(const char* arg, const char* name, long* out)
+{
+    size_t len = strlen(name);
+    if (strncmp(arg, name, len) != 0 || arg[len] != '=') {
+        return false;
+    }
+    char* end = NULL;
+    long value = strtol(arg + len + 1, &end, 10);
+    if (end == arg + len + 1 || *end != '\0' || value < 1) {
+        printf("bad value of %s, should be 1 or more, ignored.\n", name);
+        return true;
+    }
+    *out = value;
+    return true;
+}
+
+/*
+ If arg is "name=value", parse value as a seed into out and return true.
+ */
+bool _config_parse_seed(const char* arg, const char* name, uint64_t* out)
+{
+    size_t len = strlen(name);
+    if (strncmp(arg, name, len) != 0 || arg[len] != '=') {
+        return false;
+    }
+    char* end = NULL;
+    unsigned long long value = strtoull(arg + len + 1, &end, 10);
+    if (end == arg + len + 1 || *end != '\0') {
+        printf("bad value of %s, should be a number, ignored.\n", name);
+        return true;
+    }
+    *out = value;
+    return true;
+}
+
+/*
+ If arg is "name=value", point out to value and return true.
+ */
+bool _config_parse_path(const char* arg, const char* name, const char** out)
+{
+    size_t len = strlen(name);
+    if (strncmp(arg, name, len) != 0 || arg[len] != '=') {
+        return false;
+    }
+    if (arg[len + 1] == '\0') {
+        printf("%s needs a file, ignored.\n", name);
+        return true;
+    }
+    *out = arg + len + 1;
+    return true;
+}
+
+int config_init(GameConfig* config)
+{
+    config->sim_hz = DEFAULT_SIM_HZ;
+    config->render_hz = DEFAULT_RENDER_HZ;
+    config->headless = false;
+    config->threaded = false;
+    config->direct = false;
+    config->stats = false;
+    config->scale = DEFAULT_DISP_SCALE;
+    config->weapon_cooldown = WEAPON_COOLDOWN;
+    config->blast_lifetime = BLAST_LIFETIME;
+    config->headless_steps = DEFAULT_HEADLESS_STEPS;
+    config->seed = DEFAULT_SEED;
+    config->threads = DEFAULT_THREADS;
+    config->record_path = NULL;
+    config->replay_path = NULL;
+    config->trace_path = NULL;
+    return 0;
+}
+
+int config_parse_args(GameConfig* config, int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++) {
+        if (_config_parse_hz(argv[i], "--sim-hz", &config->sim_hz)) continue;
+        if (_config_parse_hz(argv[i], "--render-hz", &config->render_hz)) continue;
+        if (_config_parse_scale(argv[i], "--scale", &config->scale)) continue;
+        if (_config_parse_seconds(argv[i], "--cooldown", &config->weapon_cooldown)) continue;
+        if (_config_parse_seconds(argv[i], "--blast-life", &config->blast_lifetime)) continue;
+        if (_config_parse_count(argv[i], "--steps", &config->headless_steps)) continue;
+        if (_config_parse_count(argv[i], "--threads", &config->threads)) continue;
+        if (_config_parse_seed(argv[i], "--seed", &config->seed)) continue;
+        if (_config_parse_path(argv[i], "--record", &config->record_path)) continue;
+        if (_config_parse_path(argv[i], "--replay", &config->replay_path)) continue;
+        if (_config_parse_path(argv[i], "--trace", &config->trace_path)) continue;
+        if (strcmp(argv[i], "--headless") == 0) {
+            config->headless = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--threaded") == 0) {
+            config->threaded = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--direct") == 0) {
+            config->direct = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--stats") == 0) {
+            config->stats = true;
+            continue;
+        }
+        printf("unknown option %s, ignored.\n", argv[i]);
+    }
+    // the stats are what a headless run is for.
+    if (config->headless) {
+        config->stats = true;
+    }
+    return 0;
+}
+
+float config_sim_dt(GameConfig* config)
+{
+    return 1.0f / config->sim_hz;
+}
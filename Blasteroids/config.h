@@ -0,0 +1,71 @@
+//
+//  config.h
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/02.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+/*
+ Runtime settings, defaults from common.h, overridden by command line.
+ 
+ Options:
+    --sim-hz=N      logic steps per second, the sim runs at a fixed dt = 1/N no matter how fast it draws.
+    --render-hz=N   frames drawn per second, in between two sim steps things are interpolated.
+    --headless      no display, no keyboard: run the sim and draw to the null renderer as fast as it goes, then print the stats (--stats is on).
+    --steps=N       how many sim steps a headless run takes.
+    --seed=N        seed of the game's rng, the same seed gives the same levels. 0 or not given == from the clock.
+    --record=FILE   record the session's input into FILE.
+    --replay=FILE   play back the session in FILE instead of the keyboard, its seed and sim rate are used. With --headless it runs till the recording ends, as fast as it goes.
+    --threads=N     threads updating the asteroids, the main one included, results are the same with any N.
+    --threaded      run the sim on its own thread, drawing never holds it up. Not with --headless.
+    --trace=FILE    time the hot path, write the latest events to FILE as Chrome trace JSON on exit, or when F12 is pressed.
+    --scale=X       display size, X times the buffer (BUFFER_WIDTH x BUFFER_HEIGHT), 0.25-8.
+    --direct        draw straight to the display with a scale transform, instead of into the buffer then scaling it to the display.
+    --cooldown=S    seconds between two blasts when holding fire, 0.01-10.
+    --blast-life=S  seconds a blast flies before it's gone, 0.01-10.
+    --stats         print the seed at start, and on exit how big everything got, how often it went to the heap, and the other counters.
+ */
+
+#ifndef config_h
+#define config_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include "common.h"
+
+typedef struct {
+    float sim_hz;
+    float render_hz;
+    bool headless;
+    bool threaded;
+    bool direct;
+    bool stats;
+    float scale;
+    float weapon_cooldown;  // in seconds.
+    float blast_lifetime;   // in seconds.
+    long headless_steps;
+    uint64_t seed;
+    long threads;
+    const char* record_path;    // NULL == don't record.
+    const char* replay_path;    // NULL == play with keyboard.
+    const char* trace_path;     // NULL == no tracing.
+} GameConfig;
+
+/*
+ Fill with the defaults.
+ */
+int config_init(GameConfig* config);
+
+/*
+ Override the defaults from command line, unknown or bad options are reported and skipped.
+ */
+int config_parse_args(GameConfig* config, int argc, char** argv);
+
+/*
+ Fixed time step of the sim, in seconds.
+ */
+float config_sim_dt(GameConfig* config);
+
+
+#endif /* config_h */
@@ -0,0 +1,221 @@
+//
+//  game.c
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/07.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+#include "game.h"
+#include "aabb_batch.h"
+#include "trace.h"
+
+int game_instance_init(GAME_INSTANCE* game, uint64_t seed, int threads, float weapon_cooldown, float blast_lifetime)
+{
+    game->rng = malloc(sizeof(Rng));
+    rng_seed(game->rng, seed);
+    
+    game->ship = malloc(sizeof(Spaceship));
+    spaceship_init(game->ship, BUFFER_WIDTH/2.0, BUFFER_HEIGHT/2.0);  // space ship takes 2 float position to init, we put it on the center of the screen.
+    
+    game->life_counter = malloc(sizeof(LifeCounter));
+    lifecounter_init(game->life_counter);
+    
+    game->score = malloc(sizeof(Score));
+    // init score, params: &s, position_x, position_y, size_scale_factor
+    score_init(game->score);
+    
+    // blasts
+    game->all_blasts = malloc(sizeof(BlastCluster));
+    blastcluster_init(game->all_blasts, weapon_ring_capacity(weapon_cooldown, blast_lifetime));
+    game->weapon = malloc(sizeof(Weapon));
+    weapon_init(game->weapon, weapon_cooldown, blast_lifetime);
+    
+    // level
+    game->level = malloc(sizeof(Level));
+    level_first_init(game->level);    // level 1 as started.
+    
+    // Asteroids
+    game->all_asteroids = malloc(sizeof(AsteroidCluster));
+    asteroid_cluster_init(game->all_asteroids);
+    //it's a special case, when the game just launch, we have to init level 1's asteroids.
+    asteroid_cluster_add_some_random_asteroids(game->all_asteroids, game->level->asteroid_total, game->rng);
+    
+    // collision broadphase
+    game->grid = malloc(sizeof(BroadphaseGrid));
+    grid_init(game->grid, BUFFER_WIDTH, BUFFER_HEIGHT, GRID_CELL_SIZE);
+    // pick the widest bounding box kernel this cpu has, once, before any collision runs.
+    aabb_batch_select(AABB_KERNEL_AUTO);
+    game->sweep = malloc(sizeof(SweepAndPrune));
+    sweep_init(game->sweep, BUFFER_WIDTH, BUFFER_HEIGHT);
+    
+    game->workers = malloc(sizeof(WorkerPool));
+    worker_pool_init(game->workers, threads);
+    game->hits = malloc(sizeof(HitEvents));
+    hit_events_init(game->hits, game->workers->thread_count);
+    
+    // explosions, their own rng from the same seed, so the game's one gives what it always did.
+    game->particles = malloc(sizeof(ParticlePool));
+    particle_pool_init(game->particles, PARTICLE_BUDGET, seed);
+    
+    command_buffer_init(&game->blast_commands);
+    command_buffer_init(&game->asteroid_commands);
+    
+    return 0;
+}
+
+int game_instance_destroy(GAME_INSTANCE* game)
+{
+    spaceship_destroy(game->ship);
+    lifecounter_destroy(game->life_counter);
+    score_destroy(game->score);
+    blastcluster_destroy(game->all_blasts);
+    weapon_destroy(game->weapon);
+    asteroid_cluster_destroy(game->all_asteroids);
+    level_destroy(game->level);
+    grid_destroy(game->grid);
+    sweep_destroy(game->sweep);
+    worker_pool_destroy(game->workers);
+    hit_events_destroy(game->hits);
+    particle_pool_destroy(game->particles);
+    rng_destroy(game->rng);
+    command_buffer_release(&game->blast_commands);
+    command_buffer_release(&game->asteroid_commands);
+    free(game);
+    return 0;
+}
+
+/* Apply the input mask of this tick, so that our spaceship could move properly, the same whether it's from keyboard or a replay */
+void apply_input(GAME_INSTANCE *game, unsigned char mask, float dt) {
+    if (game->level->game_status < GAME_OVER) {
+        if(mask & INPUT_UP) {
+            spaceship_accelerate(game->ship, dt);
+        }
+        if(mask & INPUT_DOWN) {
+            spaceship_decelerate(game->ship, dt);
+        }
+        if(mask & INPUT_LEFT) {
+            spaceship_turn_left(game->ship, dt);
+        }
+        if(mask & INPUT_RIGHT) {
+            spaceship_turn_right(game->ship, dt);
+        }
+        if(mask & INPUT_FIRE) {
+            // press space, add a blast, if the weapon has cooled down.
+            weapon_fire(game->weapon, &game->blast_commands, game->ship);
+            // -- not good -- only respond to fire after level start
+//            if (game->level->game_status > LEVEL_START) {
+//                blastcluster_add_blast(game->bc, game->ship);
+//            }
+        }
+    }
+}
+
+static void game_move_to_next_level(GAME_INSTANCE *game) {
+    level_go_next(game->level);
+    // Re-prepare the asteroids of next level.
+    asteroid_cluster_add_some_random_asteroids(game->all_asteroids, game->level->asteroid_total, game->rng);
+    // No need to center the ship, it feels bad.
+    //        spaceship_reset_to_center((*game)->ship);
+    // Life ++ ???
+    lifecounter_add_one_life(game->life_counter);
+}
+
+static void run_main_game_logic(GAME_INSTANCE *game) {
+    uint64_t t = trace_begin();
+    int crashed = ship_crash_detection(game->all_asteroids, game->ship, game->sweep);
+    trace_end("ship_crash_detection", t);
+    if (crashed)
+    {
+        if (life_after_die_once(game->life_counter)==0) {
+            // if life == 0, game over
+            game->level->game_status = GAME_OVER;
+        }
+        // this will set the invicible time.
+        spaceship_just_hit(game->ship);
+    }
+    
+    // Run through all the asteroids and blasts, see if any got hit, the result score increment will be returned by asteroid_hit_detection().
+    t = trace_begin();
+    game->score->score += asteroid_hit_detection(game->all_asteroids, game->all_blasts, game->grid, game->hits, game->workers, &game->blast_commands, &game->asteroid_commands, game->particles);
+    trace_end("asteroid_hit_detection", t);
+}
+
+static bool check_if_wins(GAME_INSTANCE *game) {
+    if (game->all_asteroids->count == 0) {
+        game->level->game_status = LEVEL_WIN;
+        return true;
+    }
+    else return false;
+}
+
+/* Run game logic to determined what's happened */
+void run_game_logic(GAME_INSTANCE *game, float dt) {
+    uint64_t t = trace_begin();
+    /*
+     By default, the main game logic (detects if spaceship got hit, blast hit asteroids...) should always run.
+     Unless it's GAME_OVER which should do nothing, or NEXT_LEVEL which is a intermediate state to change game instance to next level. (prepare new asteroids, etc...)
+     
+     When and only when IN_GAME_PLAY, should always check if now level wins.
+     In other states, which is mostly for overlay text to display properly for a specific seconds, just count down the countdown ticker.
+     
+     */
+    switch (game->level->game_status) {
+        case GAME_OVER: break;
+        case NEXT_LEVEL:
+            // Move to next level.
+            game_move_to_next_level(game);
+            break;
+            
+        case IN_GAME_PLAY:
+            // If IN_GAME_PLAY check if win, then tick (nothing will happen), then hit detection.
+            // After run through all the asteroids, and no asteroid is left, you win this level, tell LEVEL you are win. (move to next level thigns happens there)
+            check_if_wins(game); // fall through
+        case NEW_LEVEL_NUMBER:
+        case LEVEL_START:
+        case LEVEL_WIN:
+            // NEW_LEVEL_NUMBER, LEVEL_START, LEVEL_WIN: tick(count down) then check hit.
+            level_tick(game->level, dt);
+            // fall through
+        default:
+            // unless GAME_OVER or switch to NEXT_LEVEL, game logic should always run.
+            // Spaceship crash detection, crash has a high priority than other collisions.
+            run_main_game_logic(game);
+            break;
+    }
+    // fire and hits, each cluster in one go.
+    blastcluster_apply(game->all_blasts, &game->blast_commands);
+    asteroid_cluster_apply(game->all_asteroids, &game->asteroid_commands);
+    trace_end("run_game_logic", t);
+}
+
+/* Update all moving elements on the screen */
+void update_and_move(GAME_INSTANCE *game, float dt) {
+    uint64_t t = trace_begin();
+    // -- Not good -- All moving elements only get moved when IN_GAME_PLAY, otherwise it should be in a pause.
+    if (1) {
+        uint64_t t_cluster = trace_begin();
+        blastcluster_update(game->all_blasts, dt, &game->blast_commands);  // blasters move
+        weapon_update(game->weapon, dt);
+        trace_end("blastcluster_update", t_cluster);
+        t_cluster = trace_begin();
+        asteroid_cluster_update(game->all_asteroids, dt, game->workers);  // asteroids move, all of them done before collision.
+        trace_end("asteroid_cluster_update", t_cluster);
+        t_cluster = trace_begin();
+        particle_pool_update(game->particles, dt);
+        trace_end("particle_pool_update", t_cluster);
+        spaceship_update(game->ship, dt);   // spaceship move
+        // the blasts off screen or too old.
+        blastcluster_apply(game->all_blasts, &game->blast_commands);
+    }
+    trace_end("update_and_move", t);
+}
+
+int game_step(GAME_INSTANCE *game, unsigned char mask, float dt)
+{
+    spaceship_keep_previous(game->ship);    // before input turns it, others keep theirs in update.
+    apply_input(game, mask, dt);   // 1. translated input to move spaceship and open fire.
+    run_game_logic(game, dt);  // 2. run game logic, collision detection, win/lose are judged here.
+    update_and_move(game, dt);  // 3. update every moving things, asteroids, blast, spaceship, all what they should be to next moment.
+    return 0;
+}
@@ -0,0 +1,85 @@
+//
+//  game.h
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/07.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+#ifndef game_h
+#define game_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "common.h"
+#include "blast.h"
+#include "weapon.h"
+#include "spaceship.h"
+#include "lifecounter.h"
+#include "score.h"
+#include "asteroids.h"
+#include "collision.h"
+#include "level.h"
+#include "rng.h"
+#include "worker_pool.h"
+
+/*
+ Game Instance
+ 
+ Game instance is to wrap everything we have around, as a game instance, so that we could pass it around, move game related logic out from main.
+ It also give you a clear mind what's in our game.
+ 
+ */
+typedef struct {
+    Spaceship* ship;    // the ship
+    LifeCounter* life_counter;
+    Score* score;
+    BlastCluster* all_blasts;   // all the blasts
+    Weapon* weapon;     // how often the ship fires, how long blasts fly.
+    Level* level;       // level 1, 2, 3...
+    AsteroidCluster* all_asteroids;    // all the asteroids.
+    Rng* rng;   // every random thing of this game comes from here.
+    BroadphaseGrid* grid;   // broadphase of blast-asteroid collision, rebuilt every tick.
+    SweepAndPrune* sweep;   // broadphase of ship-asteroid collision, kept sorted across ticks.
+    WorkerPool* workers;    // share the asteroid update and hit detection.
+    HitEvents* hits;    // hit detection's events and scratch.
+    ParticlePool* particles;    // explosions, only for show, nothing in the game depends on them.
+    // what a stage adds to or drops from the clusters, applied at the end of run_game_logic() and of update_and_move(), empty in between.
+    CommandBuffer blast_commands;
+    CommandBuffer asteroid_commands;
+} GAME_INSTANCE;
+
+/*
+ threads: how many update the asteroids, the calling one included.
+ */
+int game_instance_init(GAME_INSTANCE* game, uint64_t seed, int threads, float weapon_cooldown, float blast_lifetime);
+
+int game_instance_destroy(GAME_INSTANCE* game);
+
+/*
+ Apply the input mask (INPUT_UP, INPUT_FIRE...) of this tick.
+ A blast fired is recorded, it's in the air once run_game_logic() applies the commands, so it's hit tested from the next tick on.
+ */
+void apply_input(GAME_INSTANCE *game, unsigned char mask, float dt);
+
+/*
+ Run game logic to determined what's happened: collisions, win/lose, level changes.
+ At the end, what it and the input recorded (fire, hits) is applied to the clusters.
+ */
+void run_game_logic(GAME_INSTANCE *game, float dt);
+
+/*
+ Update all moving elements towards next moment, dt seconds later.
+ At the end, the blasts that left the screen or flew their lifetime are dropped.
+ */
+void update_and_move(GAME_INSTANCE *game, float dt);
+
+/*
+ One whole sim step of dt seconds with the input mask: input, logic, move.
+ Nothing in it needs a display, so it runs headless or in a benchmark as is.
+ */
+int game_step(GAME_INSTANCE *game, unsigned char mask, float dt);
+
+
+#endif /* game_h */
@@ -0,0 +1,229 @@
+//
+//  grid.c
+//  Blasteroids
+//
+//  Created by linxucc on 2020/11/29.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+#include "grid.h"
+#include <math.h>
+#include <string.h>
+#include "common.h"
+#include "aabb_batch.h"
+
+/*
+ Which column/row a coordinate falls in, clamped into the grid.
+ */
+int _grid_col(BroadphaseGrid* grid, float x)
+{
+    int col = (int)(x / grid->cell_size);
+    return col < 0 ? 0 : (col >= grid->cols ? grid->cols - 1 : col);
+}
+
+int _grid_row(BroadphaseGrid* grid, float y)
+{
+    int row = (int)(y / grid->cell_size);
+    return row < 0 ? 0 : (row >= grid->rows ? grid->rows - 1 : row);
+}
+
+int grid_init(BroadphaseGrid* grid, float width, float height, float cell_size)
+{
+    grid->cell_size = cell_size;
+    grid->cols = (int)ceilf(width / cell_size);
+    grid->rows = (int)ceilf(height / cell_size);
+
+    grid->min_x = NULL;
+    grid->min_y = NULL;
+    grid->max_x = NULL;
+    grid->max_y = NULL;
+    grid->query_results = NULL;
+    grid->item_count = 0;
+    grid->item_capacity = 0;
+
+    grid->cell_start = calloc(grid->cols * grid->rows + 1, sizeof(int));
+    grid->entries = NULL;
+    grid->entry_min_x = NULL;
+    grid->entry_min_y = NULL;
+    grid->entry_max_x = NULL;
+    grid->entry_max_y = NULL;
+    grid->entry_hit_masks = NULL;
+    grid->entry_count = 0;
+    grid->entry_capacity = 0;
+
+    grid->pairs_tested = 0;
+    grid->pairs_hit = 0;
+    grid->total_pairs_tested = 0;
+    grid->total_pairs_hit = 0;
+    grid->total_builds = 0;
+    return 0;
+}
+
+int grid_destroy(BroadphaseGrid* grid)
+{
+    free(grid->min_x);
+    free(grid->min_y);
+    free(grid->max_x);
+    free(grid->max_y);
+    free(grid->query_results);
+    free(grid->cell_start);
+    free(grid->entries);
+    free(grid->entry_min_x);
+    free(grid->entry_min_y);
+    free(grid->entry_max_x);
+    free(grid->entry_max_y);
+    free(grid->entry_hit_masks);
+    free(grid);
+    return 0;
+}
+
+int grid_set_item_count(BroadphaseGrid* grid, int item_count)
+{
+    // only grows, so after a few ticks there's no more heap calls.
+    if (item_count > grid->item_capacity) {
+        int new_capacity = grid->item_capacity ? grid->item_capacity : 64;
+        while (new_capacity < item_count) {
+            new_capacity *= 2;
+        }
+        char* err = "Failed when growing broadphase grid, out of memory.";
+        grid->min_x = must_realloc(grid->min_x, new_capacity * sizeof(float), err);
+        grid->min_y = must_realloc(grid->min_y, new_capacity * sizeof(float), err);
+        grid->max_x = must_realloc(grid->max_x, new_capacity * sizeof(float), err);
+        grid->max_y = must_realloc(grid->max_y, new_capacity * sizeof(float), err);
+        grid->query_results = must_realloc(grid->query_results, new_capacity * sizeof(int), err);
+        grid->item_capacity = new_capacity;
+    }
+    grid->item_count = item_count;
+    return 0;
+}
+
+int grid_build(BroadphaseGrid* grid)
+{
+    int total_cells = grid->cols * grid->rows;
+
+    // counting sort, 1st pass: count how many items each cell gets.
+    memset(grid->cell_start, 0, (total_cells + 1) * sizeof(int));
+    int entry_count = 0;
+    for (int i = 0; i < grid->item_count; i++) {
+        int c0 = _grid_col(grid, grid->min_x[i]), c1 = _grid_col(grid, grid->max_x[i]);
+        int r0 = _grid_row(grid, grid->min_y[i]), r1 = _grid_row(grid, grid->max_y[i]);
+        for (int r = r0; r <= r1; r++) {
+            for (int c = c0; c <= c1; c++) {
+                grid->cell_start[r * grid->cols + c + 1]++;
+            }
+        }
+        entry_count += (c1 - c0 + 1) * (r1 - r0 + 1);
+    }
+
+    // counts to start offsets.
+    for (int cell = 0; cell < total_cells; cell++) {
+        grid->cell_start[cell + 1] += grid->cell_start[cell];
+    }
+
+    if (entry_count > grid->entry_capacity) {
+        int new_capacity = grid->entry_capacity ? grid->entry_capacity : 256;
+        while (new_capacity < entry_count) {
+            new_capacity *= 2;
+        }
+        char* err = "Failed when growing broadphase grid entries, out of memory.";
+        grid->entries = must_realloc(grid->entries, new_capacity * sizeof(int), err);
+        grid->entry_min_x = must_realloc(grid->entry_min_x, new_capacity * sizeof(float), err);
+        grid->entry_min_y = must_realloc(grid->entry_min_y, new_capacity * sizeof(float), err);
+        grid->entry_max_x = must_realloc(grid->entry_max_x, new_capacity * sizeof(float), err);
+        grid->entry_max_y = must_realloc(grid->entry_max_y, new_capacity * sizeof(float), err);
+        grid->entry_hit_masks = must_realloc(grid->entry_hit_masks, (new_capacity / 32 + 1) * sizeof(uint32_t), err);
+        grid->entry_capacity = new_capacity;
+    }
+    grid->entry_count = entry_count;
+
+    // 2nd pass: put items in place. cell_start[c] is used as the write cursor of cell c, after this pass it's moved to the start of cell c+1...
+    for (int i = 0; i < grid->item_count; i++) {
+        int c0 = _grid_col(grid, grid->min_x[i]), c1 = _grid_col(grid, grid->max_x[i]);
+        int r0 = _grid_row(grid, grid->min_y[i]), r1 = _grid_row(grid, grid->max_y[i]);
+        for (int r = r0; r <= r1; r++) {
+            for (int c = c0; c <= c1; c++) {
+                int e = grid->cell_start[r * grid->cols + c]++;
+                grid->entries[e] = i;
+                grid->entry_min_x[e] = grid->min_x[i];
+                grid->entry_min_y[e] = grid->min_y[i];
+                grid->entry_max_x[e] = grid->max_x[i];
+                grid->entry_max_y[e] = grid->max_y[i];
+            }
+        }
+    }
+    // ...so shift everything back by one cell.
+    for (int cell = total_cells; cell > 0; cell--) {
+        grid->cell_start[cell] = grid->cell_start[cell - 1];
+    }
+    grid->cell_start[0] = 0;
+
+    grid->pairs_tested = 0;
+    grid->pairs_hit = 0;
+    grid->total_builds++;
+    return 0;
+}
+
+int grid_query_into(BroadphaseGrid* grid, float min_x, float min_y, float max_x, float max_y, int* results, uint32_t* hit_masks, long* tested)
+{
+    int found = 0;
+    int c0 = _grid_col(grid, min_x), c1 = _grid_col(grid, max_x);
+    int r0 = _grid_row(grid, min_y), r1 = _grid_row(grid, max_y);
+    for (int r = r0; r <= r1; r++) {
+        for (int c = c0; c <= c1; c++) {
+            int cell = r * grid->cols + c;
+            int start = grid->cell_start[cell];
+            int count = grid->cell_start[cell + 1] - start;
+            if (count == 0) {
+                continue;
+            }
+            *tested += count;
+            // same test as the bounding box collision, item is box 1, query is box 2. The whole cell at once.
+            if (!aabb_batch_overlap(grid->entry_min_x + start, grid->entry_min_y + start, grid->entry_max_x + start, grid->entry_max_y + start, count,
+                                    min_x, min_y, max_x, max_y, hit_masks)) {
+                continue;
+            }
+            for (int w = 0; w <= (count - 1) >> 5; w++) {
+                uint32_t bits = hit_masks[w];
+                while (bits) {
+                    int e = start + (w << 5) + __builtin_ctz(bits);
+                    bits &= bits - 1;
+                    int i = grid->entries[e];
+                    // an item and the query may share many cells, only report the pair from the cell holding the top-left corner of their overlap, so it's reported once.
+                    float overlap_x = grid->min_x[i] > min_x ? grid->min_x[i] : min_x;
+                    float overlap_y = grid->min_y[i] > min_y ? grid->min_y[i] : min_y;
+                    if (_grid_col(grid, overlap_x) != c || _grid_row(grid, overlap_y) != r) {
+                        continue;
+                    }
+                    results[found++] = i;
+                }
+            }
+        }
+    }
+    return found;
+}
+
+int grid_query(BroadphaseGrid* grid, float min_x, float min_y, float max_x, float max_y)
+{
+    long tested = 0;
+    int found = grid_query_into(grid, min_x, min_y, max_x, max_y, grid->query_results, grid->entry_hit_masks, &tested);
+    grid->pairs_tested += tested;
+    grid->pairs_hit += found;
+    grid->total_pairs_tested += tested;
+    grid->total_pairs_hit += found;
+    return found;
+}
+
+int grid_print_stats(BroadphaseGrid* grid, const char* name)
+{
+    long builds = grid->total_builds > 0 ? grid->total_builds : 1;
+    printf("grid %s: %dx%d cells of %.0f px, per tick: pairs tested %ld, pairs hit %ld (last tick: %ld, %ld)\n",
+           name,
+           grid->cols,
+           grid->rows,
+           grid->cell_size,
+           grid->total_pairs_tested / builds,
+           grid->total_pairs_hit / builds,
+           grid->pairs_tested,
+           grid->pairs_hit);
+    return 0;
+}
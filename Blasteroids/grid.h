@@ -0,0 +1,106 @@
+//
+//  grid.h
+//  Blasteroids
+//
+//  Created by linxucc on 2020/11/29.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+/*
+ Uniform grid broadphase.
+ 
+ The world (BUFFER_WIDTH x BUFFER_HEIGHT) is cut into square cells. Every tick the grid is rebuilt from the bounding boxes of all the items (blasts), each item is put into every cell its box touches.
+ A query box (an asteroid) then only needs to be tested against the items in the cells it touches, instead of all the items.
+ 
+ How to use, each tick:
+    1. grid_set_item_count(), then fill min_x/min_y/max_x/max_y of every item.
+    2. grid_build().
+    3. grid_query() as many times as needed, or grid_query_into() from many threads at once.
+ 
+ Items are only referred by their index, the grid knows nothing about what they are.
+ The boxes are also copied in cell order, so a query tests a whole cell with one batch call (see aabb_batch.h).
+ Boxes outside the world are clamped into the border cells.
+ */
+
+#ifndef grid_h
+#define grid_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+typedef struct {
+    float cell_size;
+    int cols, rows;
+
+    // bounding boxes of the items, filled by caller before build, indexed by item.
+    float* min_x;
+    float* min_y;
+    float* max_x;
+    float* max_y;
+    int item_count;
+    int item_capacity;
+
+    // cell_start[c] to cell_start[c+1] is the range in entries of cell c. (c = row * cols + col)
+    int* cell_start;
+    // item indices, grouped by cell.
+    int* entries;
+    // boxes of the entries, in the same order, so the boxes of one cell are packed together for the batch test.
+    float* entry_min_x;
+    float* entry_min_y;
+    float* entry_max_x;
+    float* entry_max_y;
+    // bitmask scratch of the batch test, one bit per entry.
+    uint32_t* entry_hit_masks;
+    int entry_count;
+    int entry_capacity;
+
+    // result of the last query, item indices, each item appears once.
+    int* query_results;
+
+    // stats of the last build, and all builds since init.
+    long pairs_tested;  // item boxes tested against a query box.
+    long pairs_hit;     // of them, how many overlapped.
+    long total_pairs_tested;
+    long total_pairs_hit;
+    long total_builds;
+} BroadphaseGrid;
+
+/*
+ Init an empty grid covering width x height, cut into cells of cell_size.
+ */
+int grid_init(BroadphaseGrid* grid, float width, float height, float cell_size);
+
+int grid_destroy(BroadphaseGrid* grid);
+
+/*
+ Make room for item_count items, caller should fill the boxes of all of them afterwards.
+ */
+int grid_set_item_count(BroadphaseGrid* grid, int item_count);
+
+/*
+ Put every item into the cells it touches. Resets the per build counters.
+ */
+int grid_build(BroadphaseGrid* grid);
+
+/*
+ Find all the items whose box overlaps the query box.
+ 
+ Return how many are found, their indices are in grid->query_results, in no particular order.
+ */
+int grid_query(BroadphaseGrid* grid, float min_x, float min_y, float max_x, float max_y);
+
+/*
+ Same as grid_query(), but the results and the bitmask scratch are the caller's, and the grid is only read, so any number of threads could query at once.
+ 
+ results needs room for item_count indices, hit_masks for entry_count / 32 + 1 words. Boxes tested are added to *tested, the grid's counters are left to the caller.
+ */
+int grid_query_into(BroadphaseGrid* grid, float min_x, float min_y, float max_x, float max_y, int* results, uint32_t* hit_masks, long* tested);
+
+/*
+ Print pairs tested and pairs hit, per build on average, to console.
+ */
+int grid_print_stats(BroadphaseGrid* grid, const char* name);
+
+
+#endif /* grid_h */
@@ -0,0 +1,194 @@
+//
+//  handle.c
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/10.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+#include "common.h"
+#include "handle.h"
+#include <string.h>
+
+int handle_table_init(HandleTable* t, int index_capacity)
+{
+    t->generation = NULL;
+    t->index = NULL;
+    t->slot_count = 0;
+    t->slot_capacity = 0;
+    t->free_head = -1;
+    t->slot_of = NULL;
+    t->index_capacity = 0;
+    t->live = 0;
+    t->stale_finds = 0;
+    handle_table_reserve(t, index_capacity);
+    return 0;
+}
+
+int handle_table_release(HandleTable* t)
+{
+    free(t->generation);
+    free(t->index);
+    free(t->slot_of);
+    return 0;
+}
+
+int handle_table_reserve(HandleTable* t, int index_capacity)
+{
+    if (index_capacity <= t->index_capacity) {
+        return 0;
+    }
+    t->slot_of = must_realloc(t->slot_of, (size_t)index_capacity * sizeof(int), "Failed when growing handle table, out of memory.");
+    t->index_capacity = index_capacity;
+    return 0;
+}
+
+/*
+ Room for slot_count slots.
+ */
+int _handle_table_reserve_slots(HandleTable* t, int slot_count)
+{
+    if (slot_count <= t->slot_capacity) {
+        return 0;
+    }
+    // the last one is HANDLE_NONE's.
+    if (slot_count > (int)HANDLE_INDEX_MASK) {
+        go_error("Out of handles, too many entities.");
+    }
+    int slot_capacity = t->slot_capacity ? t->slot_capacity : 64;
+    while (slot_capacity < slot_count) {
+        slot_capacity *= 2;
+    }
+    if (slot_capacity > (int)HANDLE_INDEX_MASK) {
+        slot_capacity = HANDLE_INDEX_MASK;
+    }
+    char* err = "Failed when growing handle table, out of memory.";
+    t->generation = must_realloc(t->generation, (size_t)slot_capacity * sizeof(uint16_t), err);
+    t->index = must_realloc(t->index, (size_t)slot_capacity * sizeof(int), err);
+    t->slot_capacity = slot_capacity;
+    return 0;
+}
+
+/*
+ A free slot, a new one if none was freed.
+ */
+int _handle_table_take_slot(HandleTable* t)
+{
+    if (t->free_head >= 0) {
+        int slot = t->free_head;
+        t->free_head = t->index[slot];
+        return slot;
+    }
+    _handle_table_reserve_slots(t, t->slot_count + 1);
+    int slot = t->slot_count++;
+    t->generation[slot] = 0;
+    return slot;
+}
+
+Handle handle_table_add(HandleTable* t, int index)
+{
+    int slot = _handle_table_take_slot(t);
+    t->index[slot] = index;
+    t->slot_of[index] = slot;
+    t->live++;
+    return (Handle)slot | ((Handle)t->generation[slot] << HANDLE_INDEX_BITS);
+}
+
+int handle_table_remove(HandleTable* t, int index)
+{
+    int slot = t->slot_of[index];
+    // every handle to it is stale.
+    t->generation[slot] = (t->generation[slot] + 1) & HANDLE_GENERATION_MASK;
+    t->index[slot] = t->free_head;
+    t->free_head = slot;
+    t->live--;
+    return 0;
+}
+
+int handle_table_move(HandleTable* t, int from, int to)
+{
+    int slot = t->slot_of[from];
+    t->index[slot] = to;
+    t->slot_of[to] = slot;
+    return 0;
+}
+
+Handle handle_table_get(HandleTable* t, int index)
+{
+    int slot = t->slot_of[index];
+    return (Handle)slot | ((Handle)t->generation[slot] << HANDLE_INDEX_BITS);
+}
+
+int handle_table_find(HandleTable* t, Handle handle)
+{
+    int slot = (int)(handle & HANDLE_INDEX_MASK);
+    if (slot >= t->slot_count) {
+        return -1;
+    }
+    if (t->generation[slot] != (handle >> HANDLE_INDEX_BITS)) {
+        t->stale_finds++;
+        return -1;
+    }
+    return t->index[slot];
+}
+
+size_t handle_table_packed_size(HandleTable* t, int count)
+{
+    // slot count, free head, then per slot the index (the next free one for a free slot) and generation, then the slot of each entity.
+    return 2 * sizeof(int) + (size_t)t->slot_count * (sizeof(int) + sizeof(uint16_t)) + (size_t)count * sizeof(int);
+}
+
+int handle_table_pack(HandleTable* t, void* dst, int count, int first, int wrap)
+{
+    // byte by byte, whatever comes before it in dst, it needs no alignment.
+    char* out = dst;
+    memcpy(out, &t->slot_count, sizeof(int));
+    out += sizeof(int);
+    memcpy(out, &t->free_head, sizeof(int));
+    out += sizeof(int);
+    memcpy(out, t->index, (size_t)t->slot_count * sizeof(int));
+    out += (size_t)t->slot_count * sizeof(int);
+    memcpy(out, t->generation, (size_t)t->slot_count * sizeof(uint16_t));
+    out += (size_t)t->slot_count * sizeof(uint16_t);
+    // at most two runs, first to wrap, then from 0.
+    int first_run = wrap - first < count ? wrap - first : count;
+    memcpy(out, t->slot_of + first, (size_t)first_run * sizeof(int));
+    memcpy(out + (size_t)first_run * sizeof(int), t->slot_of, (size_t)(count - first_run) * sizeof(int));
+    return 0;
+}
+
+int handle_table_unpack(HandleTable* t, const void* src, int count)
+{
+    const char* in = src;
+    int slot_count;
+    memcpy(&slot_count, in, sizeof(int));
+    in += sizeof(int);
+    _handle_table_reserve_slots(t, slot_count);
+    t->slot_count = slot_count;
+    memcpy(&t->free_head, in, sizeof(int));
+    in += sizeof(int);
+    memcpy(t->index, in, (size_t)slot_count * sizeof(int));
+    in += (size_t)slot_count * sizeof(int);
+    memcpy(t->generation, in, (size_t)slot_count * sizeof(uint16_t));
+    in += (size_t)slot_count * sizeof(uint16_t);
+    handle_table_reserve(t, count);
+    memcpy(t->slot_of, in, (size_t)count * sizeof(int));
+    // the live slots point at where their entities are now.
+    for (int k = 0; k < count; k++) {
+        t->index[t->slot_of[k]] = k;
+    }
+    t->live = count;
+    return 0;
+}
+
+int handle_table_clear(HandleTable* t)
+{
+    // every slot freed, the free ones too, their generation going up does no harm. Slot 0 is on top, so they're given out in order again.
+    for (int slot = t->slot_count - 1; slot >= 0; slot--) {
+        t->generation[slot] = (t->generation[slot] + 1) & HANDLE_GENERATION_MASK;
+        t->index[slot] = slot + 1 < t->slot_count ? slot + 1 : -1;
+    }
+    t->free_head = t->slot_count ? 0 : -1;
+    t->live = 0;
+    return 0;
+}
@@ -0,0 +1,114 @@
+//
+//  handle.h
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/10.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+/*
+ Handles, a way to refer to an entity (an asteroid, a blast) that stays good however its storage moves it around.
+ 
+ An index into the arrays is only good until the next remove: asteroids swap-remove, blasts slide towards head. A handle is not an index, it's 32 bits:
+    low HANDLE_INDEX_BITS   -- a slot in the table, the entity keeps its slot as long as it lives.
+    high HANDLE_GENERATION_BITS -- generation of the slot when the handle was given out.
+ The table maps each slot to where its entity is now, and back. Storage tells the table when it adds, removes or moves an entity, then finding an entity by handle is two array reads.
+ When an entity is removed its slot's generation goes up, so every handle to it is stale from then on, finding it gives -1 instead of whatever took the slot. A slot is reused after that, the newest freed first.
+ The generation wraps after 4096 reuses of one slot, a handle kept that long could point to a new entity, nothing keeps one more than a tick or so.
+ 
+ Nothing in the hot loops uses handles, they go by index. Handles are for references held across a remove, and for removes themselves.
+ */
+
+#ifndef handle_h
+#define handle_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HANDLE_INDEX_BITS 20
+#define HANDLE_GENERATION_BITS 12
+#define HANDLE_INDEX_MASK ((1u << HANDLE_INDEX_BITS) - 1)
+#define HANDLE_GENERATION_MASK ((1u << HANDLE_GENERATION_BITS) - 1)
+// refers to nothing, never found.
+#define HANDLE_NONE 0xFFFFFFFFu
+
+typedef uint32_t Handle;
+
+typedef struct {
+    // per slot
+    uint16_t* generation;
+    int* index;     // where its entity is, or the next free slot when it's free.
+    int slot_count;     // slots ever given out.
+    int slot_capacity;
+    int free_head;      // the newest freed slot, -1 == none.
+    // per entity, by where it is in the storage.
+    int* slot_of;
+    int index_capacity;
+    int live;
+    long stale_finds;   // finds of a handle to a removed entity.
+} HandleTable;
+
+/*
+ An empty table for a storage of index_capacity entities, the table itself is part of the storage, it's not allocated here.
+ */
+int handle_table_init(HandleTable* t, int index_capacity);
+
+/*
+ Free the arrays, not the table.
+ */
+int handle_table_release(HandleTable* t);
+
+/*
+ The storage grew, room for entities at index up to index_capacity - 1.
+ */
+int handle_table_reserve(HandleTable* t, int index_capacity);
+
+/*
+ A new entity at index, it gets a slot, return its handle.
+ */
+Handle handle_table_add(HandleTable* t, int index);
+
+/*
+ The entity at index is removed, its handles are stale from now on. The storage moves another one into index after it, if any, by handle_table_move().
+ */
+int handle_table_remove(HandleTable* t, int index);
+
+/*
+ The entity at from is now at to, its handles still find it.
+ */
+int handle_table_move(HandleTable* t, int from, int to);
+
+/*
+ Handle of the entity at index.
+ */
+Handle handle_table_get(HandleTable* t, int index);
+
+/*
+ Where the entity of handle is now, -1 when it's gone (or it's HANDLE_NONE).
+ */
+int handle_table_find(HandleTable* t, Handle handle);
+
+/*
+ Every entity is removed, every handle is stale.
+ */
+int handle_table_clear(HandleTable* t);
+
+/*
+ Size in bytes of the table packed by handle_table_pack() with count entities.
+ */
+size_t handle_table_packed_size(HandleTable* t, int count);
+
+/*
+ Copy the table into dst, all of it that decides which handles come next (generations, free slots), and the slot of each of count entities, entity k is the one at index (first + k) % wrap.
+ So a storage packing its entities in another order than it keeps them (a ring, oldest first) packs the table the same way.
+ */
+int handle_table_pack(HandleTable* t, void* dst, int count, int first, int wrap);
+
+/*
+ Replace the table with the one packed in src, entity k is now at index k. Every handle from when it was packed finds its entity again.
+ */
+int handle_table_unpack(HandleTable* t, const void* src, int count);
+
+
+#endif /* handle_h */
@@ -0,0 +1,59 @@
+//
+//  hud_cache.c
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/11.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+#include "hud_cache.h"
+#include <string.h>
+
+int hud_cache_init(HudCache* cache)
+{
+    cache->bitmap = NULL;
+    cache->key[0] = '\0';
+    cache->valid = false;
+    cache->width = 0;
+    cache->height = 0;
+    cache->rebuilds = 0;
+    return 0;
+}
+
+int hud_cache_release(HudCache* cache, Renderer* r)
+{
+    render_destroy_bitmap(r, cache->bitmap);
+    cache->bitmap = NULL;
+    cache->valid = false;
+    return 0;
+}
+
+bool hud_cache_begin(HudCache* cache, Renderer* r, const char* key, int width, int height)
+{
+    if (cache->valid && strcmp(cache->key, key) == 0) {
+        return false;
+    }
+    // a new bitmap only if the size changed, a score going from 999 to 1000 gets wider.
+    if (!cache->bitmap || width != cache->width || height != cache->height) {
+        render_destroy_bitmap(r, cache->bitmap);
+        cache->bitmap = render_create_bitmap(r, width, height);
+        cache->width = width;
+        cache->height = height;
+    }
+    snprintf(cache->key, sizeof(cache->key), "%s", key);
+    cache->valid = true;
+    cache->rebuilds++;
+    render_begin_offscreen(r, cache->bitmap);
+    return true;
+}
+
+int hud_cache_end(HudCache* cache, Renderer* r)
+{
+    render_end_offscreen(r);
+    return 0;
+}
+
+int hud_cache_draw(HudCache* cache, Renderer* r, float x, float y)
+{
+    return render_bitmap(r, cache->bitmap, x, y);
+}
@@ -0,0 +1,59 @@
+//
+//  hud_cache.h
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/11.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+/*
+ Cache of one HUD element (score, lives, an overlay message) as a bitmap.
+ 
+ The element is keyed by the text it shows (for lives, the count as text). Each frame the caller asks hud_cache_begin() with the key of now:
+    changed -- it returns true, the bitmap is (re)made at the size asked and is the draw target, caller draws the element into it, then hud_cache_end().
+    same    -- it returns false, nothing to draw.
+ Either way hud_cache_draw() then puts the bitmap on the frame, one blit.
+ So text is only rasterized when the score, the lives or the message changes, not every frame.
+ */
+
+#ifndef hud_cache_h
+#define hud_cache_h
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "renderer.h"
+
+#define HUD_CACHE_KEY_SIZE 32
+
+typedef struct {
+    ALLEGRO_BITMAP* bitmap;     // NULL before the first draw, or on the null backend.
+    char key[HUD_CACHE_KEY_SIZE];
+    bool valid;     // key is what bitmap holds.
+    int width, height;
+    long rebuilds;
+} HudCache;
+
+int hud_cache_init(HudCache* cache);
+
+/*
+ Free the bitmap, the cache itself is part of something else, it's not freed.
+ */
+int hud_cache_release(HudCache* cache, Renderer* r);
+
+/*
+ If key isn't what's cached, make the bitmap width x height, clear it and draw into it from now on, return true. Else return false.
+ */
+bool hud_cache_begin(HudCache* cache, Renderer* r, const char* key, int width, int height);
+
+/*
+ Done drawing into the bitmap, back to the frame.
+ */
+int hud_cache_end(HudCache* cache, Renderer* r);
+
+/*
+ Draw the bitmap with its top left at x, y.
+ */
+int hud_cache_draw(HudCache* cache, Renderer* r, float x, float y);
+
+
+#endif /* hud_cache_h */
@@ -66,10 +66,10 @@ int level_go_next(Level* level)
 }
 
 /*
- Tick, if current status has a countdown, tick it down once
+ Tick, if current status has a countdown, tick it down by dt seconds.
  Return value will be value after tick down.
  */
-float level_tick(Level* level)
+float level_tick(Level* level, float dt)
 {
     switch (level->game_status) {
         case IN_GAME_PLAY:      // fall through to GAME_OVER
@@ -82,7 +82,7 @@ float level_tick(Level* level)
         case LEVEL_START:
             if (level->count_down_of_game_status[level->game_status] > 0 ) {
                 // count down not over yet.
-                level->count_down_of_game_status[level->game_status] -= 1.0/GAME_FPS;
+                level->count_down_of_game_status[level->game_status] -= dt;
                 return level->count_down_of_game_status[level->game_status];
             } else {
                 // count down is over.
@@ -39,7 +39,7 @@ int level_first_init(Level* level);
 
 int level_go_next(Level* level);
 
-float level_tick(Level* level);
+float level_tick(Level* level, float dt);
 
 bool is_game_over(Level* level);
 
@@ -8,6 +8,7 @@
 
 
 #include "lifecounter.h"
+#include <math.h>
 
 
 /*
@@ -44,23 +45,42 @@ int lifecounter_init(LifeCounter* life_counter)
 /*
  Draw this life counter as its setting goes.
  */
-int lifecounter_draw(LifeCounter* life_counter)
+int lifecounter_draw(LifeCounter* life_counter, Renderer* r, HudCache* cache)
 {
-    int i = 0;
-    // draw each life indicator once at a time, then move template to next place.
-    while ((life_counter->life_left > 0) && (i<life_counter->life_left)) {
-        // move template right to 1 padding space, if it's not the first indicator.
-        if(i>0) {
-            life_counter->indicator_template->x += life_counter->indicator_padding * life_counter->indicator_template->scale;
+    Spaceship* template = life_counter->indicator_template;
+    float step = life_counter->indicator_padding * template->scale;
+    int lives = life_counter->life_left > 0 ? life_counter->life_left : 0;
+    // the cache covers all the indicators, the first one is LIFE_COUNTER_CACHE_MARGIN from its top left.
+    float left = life_counter->original_x - LIFE_COUNTER_CACHE_MARGIN;
+    float top = life_counter->original_y - LIFE_COUNTER_CACHE_MARGIN;
+    char key[16];
+    snprintf(key, sizeof(key), "%d", lives);
+    int width = (int)ceilf(LIFE_COUNTER_CACHE_MARGIN * 2 + step * (lives > 0 ? lives - 1 : 0));
+    int height = (int)ceilf(LIFE_COUNTER_CACHE_MARGIN * 2);
+    if (hud_cache_begin(cache, r, key, width, height)) {
+        // lives changed, draw them into the cache: the template in cache coordinates.
+        template->x = life_counter->original_x - left;
+        template->y = life_counter->original_y - top;
+        int i = 0;
+        // draw each life indicator once at a time, then move template to next place.
+        while (i < lives) {
+            // move template right to 1 padding space, if it's not the first indicator.
+            if(i>0) {
+                template->x += step;
+            }
+            spaceship_keep_previous(template);  // it's not moving, nothing to interpolate.
+            // draw the template
+            spaceship_draw(template, 1.0, r);
+            // move to next
+            i++;
         }
-        // draw the template
-        spaceship_draw(life_counter->indicator_template);
-        // move to next
-        i++;
+        hud_cache_end(cache, r);
+        // after all the draw, reset template to left-most place.
+        template->x = life_counter->original_x;
+        template->y = life_counter->original_y;
+        spaceship_keep_previous(template);
     }
-    // after all the draw, reset template to left-most place.
-    life_counter->indicator_template->x = life_counter->original_x;
-    // y is not changed for now, so don't include it.
+    hud_cache_draw(cache, r, left, top);
     return 0;
 }
 
@@ -22,7 +22,10 @@ typedef struct {
 
 int lifecounter_init(LifeCounter* life_counter);
 
-int lifecounter_draw(LifeCounter* life_counter);
+/*
+ Draw the indicators through cache, they are only drawn again when the lives change.
+ */
+int lifecounter_draw(LifeCounter* life_counter, Renderer* r, HudCache* cache);
 
 int life_after_die_once(LifeCounter* life_counter);
 
@@ -0,0 +1,178 @@
+//
+//  particles.c
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/09.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+#include "particles.h"
+#include <string.h>
+#include <math.h>
+
+/*
+ Arrays in the arena, in this order, the same order pack and unpack use.
+ */
+float* _particle_array(ParticlePool* pool, int k)
+{
+    return (float*)((char*)pool->arena + (size_t)k * pool->capacity * 4);
+}
+
+int particle_pool_init(ParticlePool* pool, int capacity, uint64_t seed)
+{
+    pool->arena = NULL;
+    if (posix_memalign(&pool->arena, PARTICLE_ARENA_ALIGN, (size_t)capacity * PARTICLE_ARRAY_COUNT * 4) != 0) {
+        go_error("Failed when allocating particles, out of memory.");
+    }
+    pool->capacity = capacity;
+    pool->x = _particle_array(pool, 0);
+    pool->y = _particle_array(pool, 1);
+    pool->vx = _particle_array(pool, 2);
+    pool->vy = _particle_array(pool, 3);
+    pool->prev_x = _particle_array(pool, 4);
+    pool->prev_y = _particle_array(pool, 5);
+    pool->age = _particle_array(pool, 6);
+    pool->head = 0;
+    pool->count = 0;
+    rng_seed(&pool->rng, seed);
+    pool->color = al_map_rgb(241, 196, 15);
+    pool->spawned = 0;
+    pool->recycled = 0;
+    return 0;
+}
+
+int particle_pool_destroy(ParticlePool* pool)
+{
+    free(pool->arena);
+    free(pool);
+    return 0;
+}
+
+int particle_pool_burst(ParticlePool* pool, float x, float y, int count)
+{
+    for (int n = 0; n < count; n++) {
+        int i;
+        if (pool->count == pool->capacity) {
+            // out of budget, the oldest one goes.
+            i = pool->head;
+            pool->head = (pool->head + 1) % pool->capacity;
+            pool->recycled++;
+        }
+        else {
+            i = (pool->head + pool->count) % pool->capacity;
+            pool->count++;
+        }
+        float heading = rng_float(&pool->rng, 0, 2 * ALLEGRO_PI);
+        float speed = rng_float(&pool->rng, PARTICLE_MIN_SPEED, PARTICLE_MAX_SPEED);
+        pool->x[i] = x;
+        pool->y[i] = y;
+        pool->vx[i] = speed * cosf(heading);
+        pool->vy[i] = speed * sinf(heading);
+        // new one, nothing to interpolate from.
+        pool->prev_x[i] = x;
+        pool->prev_y[i] = y;
+        pool->age[i] = 0;
+    }
+    pool->spawned += count;
+    return 0;
+}
+
+/*
+ Move particles [begin, end) of the arrays, no wrapping inside.
+ */
+void _particle_pool_update_range(ParticlePool* pool, int begin, int end, float dt)
+{
+    float* restrict x = pool->x;
+    float* restrict y = pool->y;
+    float* restrict vx = pool->vx;
+    float* restrict vy = pool->vy;
+    float* restrict prev_x = pool->prev_x;
+    float* restrict prev_y = pool->prev_y;
+    float* restrict age = pool->age;
+    for (int i = begin; i < end; i++) {
+        prev_x[i] = x[i];
+        prev_y[i] = y[i];
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        age[i] += dt;
+    }
+}
+
+int particle_pool_update(ParticlePool* pool, float dt)
+{
+    // the ring is at most two runs of the arrays: head to the end, then from 0.
+    int end = pool->head + pool->count;
+    _particle_pool_update_range(pool, pool->head, end < pool->capacity ? end : pool->capacity, dt);
+    if (end > pool->capacity) {
+        _particle_pool_update_range(pool, 0, end - pool->capacity, dt);
+    }
+    // all live the same time, so the ones too old are all at head.
+    while (pool->count > 0 && pool->age[pool->head] >= PARTICLE_LIFETIME) {
+        pool->head = (pool->head + 1) % pool->capacity;
+        pool->count--;
+    }
+    return 0;
+}
+
+void _particle_pool_draw_range(ParticlePool* pool, int begin, int end, float alpha, PrimBatch* batch)
+{
+    float half = PARTICLE_SIZE / 2;
+    ALLEGRO_COLOR c = pool->color;
+    for (int i = begin; i < end; i++) {
+        float x = lerp_f(pool->prev_x[i], pool->x[i], alpha);
+        float y = lerp_f(pool->prev_y[i], pool->y[i], alpha);
+        // premultiplied alpha, so fading is scaling all four.
+        float fade = 1 - pool->age[i] / PARTICLE_LIFETIME;
+        ALLEGRO_COLOR color = { c.r * fade, c.g * fade, c.b * fade, c.a * fade };
+        prim_batch_add_quad(batch, x - half, y - half, x + half, y - half, x + half, y + half, x - half, y + half, color);
+    }
+}
+
+int particle_pool_draw(ParticlePool* pool, float alpha, PrimBatch* batch)
+{
+    int end = pool->head + pool->count;
+    _particle_pool_draw_range(pool, pool->head, end < pool->capacity ? end : pool->capacity, alpha, batch);
+    if (end > pool->capacity) {
+        _particle_pool_draw_range(pool, 0, end - pool->capacity, alpha, batch);
+    }
+    return 0;
+}
+
+size_t particle_pool_packed_size(ParticlePool* pool)
+{
+    return (size_t)pool->count * PARTICLE_ARRAY_COUNT * 4;
+}
+
+int particle_pool_pack(ParticlePool* pool, void* dst)
+{
+    // unrolled, oldest first, so it's the same whatever head was.
+    int first_run = pool->capacity - pool->head < pool->count ? pool->capacity - pool->head : pool->count;
+    size_t size = (size_t)pool->count * 4;
+    for (int k = 0; k < PARTICLE_ARRAY_COUNT; k++) {
+        float* array = _particle_array(pool, k);
+        char* out = (char*)dst + k * size;
+        memcpy(out, array + pool->head, (size_t)first_run * 4);
+        memcpy(out + (size_t)first_run * 4, array, (size_t)(pool->count - first_run) * 4);
+    }
+    return 0;
+}
+
+int particle_pool_unpack(ParticlePool* pool, const void* src, int count)
+{
+    if (count > pool->capacity) {
+        go_error("More particles than the budget.");
+    }
+    size_t size = (size_t)count * 4;
+    for (int k = 0; k < PARTICLE_ARRAY_COUNT; k++) {
+        memcpy(_particle_array(pool, k), (const char*)src + k * size, size);
+    }
+    pool->head = 0;
+    pool->count = count;
+    return 0;
+}
+
+int particle_pool_print_stats(ParticlePool* pool)
+{
+    printf("particles: budget %d, live %d, spawned %ld, recycled %ld\n", pool->capacity, pool->count, pool->spawned, pool->recycled);
+    return 0;
+}
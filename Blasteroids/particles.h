@@ -0,0 +1,95 @@
+//
+//  particles.h
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/09.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+/*
+ Explosion particles, a fixed budget of them.
+
+ Structure of arrays like the asteroids (asteroids.h), all in one arena allocated at init, capacity (the budget) elements each. It never grows, spawning or dying is no heap call.
+
+ The particles are a ring, in the order they were spawned: the oldest at head, count of them after it, wrapping around the end of the arrays.
+ Every particle lives PARTICLE_LIFETIME seconds, so the oldest is always the first to die, dying is only moving head.
+ When the budget is used up, a new particle takes the place of the oldest one (recycled), however many asteroids blow up in one tick.
+
+ They have their own rng, so explosions never change what the game's rng gives, the same seed still gives the same levels.
+ */
+
+#ifndef particles_h
+#define particles_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <allegro5/allegro5.h>
+#include "common.h"
+#include "rng.h"
+#include "prim_batch.h"
+
+// arrays in the arena, all of them are 4 bytes a particle.
+#define PARTICLE_ARRAY_COUNT 7
+// the arena starts on a cache line.
+#define PARTICLE_ARENA_ALIGN 64
+
+typedef struct {
+    void* arena;    // all the arrays below point into it.
+    float* x;
+    float* y;
+    float* vx;  // in px/second
+    float* vy;
+    // position at the end of last sim step, drawing interpolates from it.
+    float* prev_x;
+    float* prev_y;
+    float* age;     // in seconds, dies at PARTICLE_LIFETIME.
+    int head;       // the oldest one.
+    int count;      // alive, from head on.
+    int capacity;   // the budget.
+    Rng rng;
+    ALLEGRO_COLOR color;
+    long spawned;
+    long recycled;  // spawned over the oldest one, the budget was used up.
+} ParticlePool;
+
+/*
+ Allocate the whole budget, capacity particles, at once. seed is for its own rng.
+ */
+int particle_pool_init(ParticlePool* pool, int capacity, uint64_t seed);
+
+int particle_pool_destroy(ParticlePool* pool);
+
+/*
+ An explosion at x, y: count particles flying out from it, random directions and speeds.
+ */
+int particle_pool_burst(ParticlePool* pool, float x, float y, int count);
+
+/*
+ Move every particle dt seconds on, the ones that got too old die.
+ */
+int particle_pool_update(ParticlePool* pool, float dt);
+
+/*
+ Add every particle to batch as a small quad fading out with age, at alpha (0-1) of the way from the previous sim step. Caller flushes it.
+ */
+int particle_pool_draw(ParticlePool* pool, float alpha, PrimBatch* batch);
+
+/*
+ Size in bytes of the particles packed by particle_pool_pack(), it's count * PARTICLE_ARRAY_COUNT * 4.
+ */
+size_t particle_pool_packed_size(ParticlePool* pool);
+
+/*
+ Copy every particle into dst, oldest first, array by array. dst has to hold particle_pool_packed_size() bytes.
+ */
+int particle_pool_pack(ParticlePool* pool, void* dst);
+
+/*
+ Replace every particle with the count ones packed in src by particle_pool_pack(), count is at most the budget.
+ */
+int particle_pool_unpack(ParticlePool* pool, const void* src, int count);
+
+int particle_pool_print_stats(ParticlePool* pool);
+
+
+#endif /* particles_h */
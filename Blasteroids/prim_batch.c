@@ -0,0 +1,96 @@
+//
+//  prim_batch.c
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/03.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+#include "prim_batch.h"
+#include <math.h>
+#include "common.h"
+
+// 2 triangles per quad.
+#define PRIM_BATCH_VERTICES_PER_QUAD 6
+
+int _prim_batch_reserve(PrimBatch* batch, int more)
+{
+    if (batch->vertex_count + more <= batch->vertex_capacity) {
+        return 0;
+    }
+    int new_capacity = batch->vertex_capacity ? batch->vertex_capacity : 1024;
+    while (new_capacity < batch->vertex_count + more) {
+        new_capacity *= 2;
+    }
+    batch->vertices = must_realloc(batch->vertices, new_capacity * sizeof(ALLEGRO_VERTEX), "Failed when growing primitive batch, out of memory.");
+    batch->vertex_capacity = new_capacity;
+    return 0;
+}
+
+void _prim_batch_put(ALLEGRO_VERTEX* v, float x, float y, ALLEGRO_COLOR color)
+{
+    v->x = x;
+    v->y = y;
+    v->z = 0;
+    v->u = 0;
+    v->v = 0;
+    v->color = color;
+}
+
+int prim_batch_init(PrimBatch* batch)
+{
+    batch->vertices = NULL;
+    batch->vertex_count = 0;
+    batch->vertex_capacity = 0;
+    return 0;
+}
+
+int prim_batch_destroy(PrimBatch* batch)
+{
+    free(batch->vertices);
+    free(batch);
+    return 0;
+}
+
+int prim_batch_add_quad(PrimBatch* batch, float ax, float ay, float bx, float by, float cx, float cy, float dx, float dy, ALLEGRO_COLOR color)
+{
+    _prim_batch_reserve(batch, PRIM_BATCH_VERTICES_PER_QUAD);
+    ALLEGRO_VERTEX* v = batch->vertices + batch->vertex_count;
+    // a-b-c and a-c-d.
+    _prim_batch_put(v + 0, ax, ay, color);
+    _prim_batch_put(v + 1, bx, by, color);
+    _prim_batch_put(v + 2, cx, cy, color);
+    _prim_batch_put(v + 3, ax, ay, color);
+    _prim_batch_put(v + 4, cx, cy, color);
+    _prim_batch_put(v + 5, dx, dy, color);
+    batch->vertex_count += PRIM_BATCH_VERTICES_PER_QUAD;
+    return 0;
+}
+
+int prim_batch_add_line(PrimBatch* batch, float x1, float y1, float x2, float y2, ALLEGRO_COLOR color, float thickness)
+{
+    float dx = x2 - x1;
+    float dy = y2 - y1;
+    float length = sqrtf(dx * dx + dy * dy);
+    if (length == 0) {
+        return 0;   // nothing to see, al_draw_line() draws nothing either.
+    }
+    // half thickness, perpendicular to the line.
+    float nx = -dy / length * thickness / 2;
+    float ny = dx / length * thickness / 2;
+    return prim_batch_add_quad(batch, x1 + nx, y1 + ny, x2 + nx, y2 + ny, x2 - nx, y2 - ny, x1 - nx, y1 - ny, color);
+}
+
+int prim_batch_flush(PrimBatch* batch, Renderer* r)
+{
+    if (batch->vertex_count == 0) {
+        return 0;
+    }
+    // points are in buffer coordinates already.
+    ALLEGRO_TRANSFORM transform;
+    al_identity_transform(&transform);
+    render_use_transform(r, &transform);
+    render_triangles(r, batch->vertices, batch->vertex_count);
+    batch->vertex_count = 0;
+    return 0;
+}
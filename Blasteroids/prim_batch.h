@@ -0,0 +1,53 @@
+//
+//  prim_batch.h
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/03.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+/*
+ Batch of primitives, drawn with one draw call.
+ 
+ Instead of al_use_transform() then al_draw_line() for each line, callers transform the points on cpu themselves, and add the lines here in screen (buffer) coordinates.
+ A thick line is expanded to a quad, 2 triangles, the same shape al_draw_line() gives. All the triangles go into one shared vertex array, flush submits them all at once.
+ 
+ The vertex array only grows, so after a few frames there's no more heap calls.
+ */
+
+#ifndef prim_batch_h
+#define prim_batch_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <allegro5/allegro5.h>
+#include <allegro5/allegro_primitives.h>
+#include "renderer.h"
+
+typedef struct {
+    ALLEGRO_VERTEX* vertices;
+    int vertex_count;
+    int vertex_capacity;
+} PrimBatch;
+
+int prim_batch_init(PrimBatch* batch);
+
+int prim_batch_destroy(PrimBatch* batch);
+
+/*
+ Add a line of thickness from (x1, y1) to (x2, y2), as 2 triangles.
+ */
+int prim_batch_add_line(PrimBatch* batch, float x1, float y1, float x2, float y2, ALLEGRO_COLOR color, float thickness);
+
+/*
+ Add a quad already expanded by caller, corners a-b-c-d in order around it.
+ */
+int prim_batch_add_quad(PrimBatch* batch, float ax, float ay, float bx, float by, float cx, float cy, float dx, float dy, ALLEGRO_COLOR color);
+
+/*
+ Submit everything added so far to r as one triangle list (one al_draw_prim), under identity transform, then empty the batch.
+ */
+int prim_batch_flush(PrimBatch* batch, Renderer* r);
+
+
+#endif /* prim_batch_h */
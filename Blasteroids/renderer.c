@@ -0,0 +1,388 @@
+//
+//  renderer.c
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/04.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+#include "renderer.h"
+#include <string.h>
+#include "common.h"
+
+/*
+ Allegro backend.
+ */
+
+int _allegro_begin_frame(Renderer* r, ALLEGRO_COLOR clear_color)
+{
+    // set draw target to our buffer
+    al_set_target_bitmap(r->buffer);
+    al_clear_to_color(clear_color);
+    return 0;
+}
+
+int _allegro_end_frame(Renderer* r)
+{
+    al_set_target_backbuffer(r->disp);
+    al_draw_scaled_bitmap(r->buffer, 0, 0, BUFFER_WIDTH, BUFFER_HEIGHT, 0, 0, BUFFER_WIDTH * r->scale, BUFFER_HEIGHT * r->scale, 0);     // Scale happens here,
+    al_flip_display();
+    return 0;
+}
+
+int _allegro_direct_begin_frame(Renderer* r, ALLEGRO_COLOR clear_color)
+{
+    // the backbuffer stays the target, only offscreen drawing moves it.
+    al_set_target_backbuffer(r->disp);
+    al_clear_to_color(clear_color);
+    return 0;
+}
+
+int _allegro_direct_end_frame(Renderer* r)
+{
+    al_flip_display();
+    return 0;
+}
+
+int _allegro_use_transform(Renderer* r, const ALLEGRO_TRANSFORM* transform)
+{
+    if (r->offscreen) {
+        al_use_transform(transform);
+        return 0;
+    }
+    // the game's transform first, then the view scales it to the display.
+    ALLEGRO_TRANSFORM t;
+    al_copy_transform(&t, transform);
+    al_compose_transform(&t, &r->view);
+    al_use_transform(&t);
+    return 0;
+}
+
+int _allegro_line(Renderer* r, float x1, float y1, float x2, float y2, ALLEGRO_COLOR color, float thickness)
+{
+    al_draw_line(x1, y1, x2, y2, color, thickness);
+    return 0;
+}
+
+int _allegro_filled_rectangle(Renderer* r, float x1, float y1, float x2, float y2, ALLEGRO_COLOR color)
+{
+    al_draw_filled_rectangle(x1, y1, x2, y2, color);
+    return 0;
+}
+
+int _allegro_triangles(Renderer* r, const ALLEGRO_VERTEX* vertices, int vertex_count)
+{
+    al_draw_prim(vertices, NULL, NULL, 0, vertex_count, ALLEGRO_PRIM_TRIANGLE_LIST);
+    return 0;
+}
+
+int _allegro_text(Renderer* r, const ALLEGRO_FONT* font, ALLEGRO_COLOR color, float x, float y, int flags, const char* text)
+{
+    al_draw_text(font, color, x, y, flags, text);
+    return 0;
+}
+
+ALLEGRO_BITMAP* _allegro_create_bitmap(Renderer* r, int width, int height)
+{
+    return al_create_bitmap(width, height);
+}
+
+int _allegro_destroy_bitmap(Renderer* r, ALLEGRO_BITMAP* bitmap)
+{
+    al_destroy_bitmap(bitmap);
+    return 0;
+}
+
+int _allegro_begin_offscreen(Renderer* r, ALLEGRO_BITMAP* bitmap)
+{
+    r->offscreen = true;
+    al_set_target_bitmap(bitmap);
+    al_clear_to_color(al_map_rgba(0, 0, 0, 0));
+    return 0;
+}
+
+int _allegro_end_offscreen(Renderer* r)
+{
+    r->offscreen = false;
+    if (r->buffer) {
+        al_set_target_bitmap(r->buffer);
+    }
+    else {
+        al_set_target_backbuffer(r->disp);
+    }
+    return 0;
+}
+
+int _allegro_bitmap(Renderer* r, ALLEGRO_BITMAP* bitmap, float x, float y)
+{
+    // at x, y in buffer px, the view scales it when drawing direct.
+    ALLEGRO_TRANSFORM identity;
+    al_identity_transform(&identity);
+    _allegro_use_transform(r, &identity);
+    al_draw_bitmap(bitmap, x, y, 0);
+    return 0;
+}
+
+/*
+ Null backend, every function does nothing.
+ */
+
+int _null_begin_frame(Renderer* r, ALLEGRO_COLOR clear_color)
+{
+    return 0;
+}
+
+int _null_end_frame(Renderer* r)
+{
+    return 0;
+}
+
+int _null_use_transform(Renderer* r, const ALLEGRO_TRANSFORM* transform)
+{
+    return 0;
+}
+
+int _null_line(Renderer* r, float x1, float y1, float x2, float y2, ALLEGRO_COLOR color, float thickness)
+{
+    return 0;
+}
+
+int _null_filled_rectangle(Renderer* r, float x1, float y1, float x2, float y2, ALLEGRO_COLOR color)
+{
+    return 0;
+}
+
+int _null_triangles(Renderer* r, const ALLEGRO_VERTEX* vertices, int vertex_count)
+{
+    return 0;
+}
+
+int _null_text(Renderer* r, const ALLEGRO_FONT* font, ALLEGRO_COLOR color, float x, float y, int flags, const char* text)
+{
+    return 0;
+}
+
+ALLEGRO_BITMAP* _null_create_bitmap(Renderer* r, int width, int height)
+{
+    return NULL;
+}
+
+int _null_destroy_bitmap(Renderer* r, ALLEGRO_BITMAP* bitmap)
+{
+    return 0;
+}
+
+int _null_begin_offscreen(Renderer* r, ALLEGRO_BITMAP* bitmap)
+{
+    return 0;
+}
+
+int _null_end_offscreen(Renderer* r)
+{
+    return 0;
+}
+
+int _null_bitmap(Renderer* r, ALLEGRO_BITMAP* bitmap, float x, float y)
+{
+    return 0;
+}
+
+int renderer_init_allegro(Renderer* r, ALLEGRO_DISPLAY* disp, ALLEGRO_BITMAP* buffer, float scale)
+{
+    r->begin_frame = _allegro_begin_frame;
+    r->end_frame = _allegro_end_frame;
+    r->use_transform = _allegro_use_transform;
+    r->line = _allegro_line;
+    r->filled_rectangle = _allegro_filled_rectangle;
+    r->triangles = _allegro_triangles;
+    r->text = _allegro_text;
+    r->create_bitmap = _allegro_create_bitmap;
+    r->destroy_bitmap = _allegro_destroy_bitmap;
+    r->begin_offscreen = _allegro_begin_offscreen;
+    r->end_offscreen = _allegro_end_offscreen;
+    r->bitmap = _allegro_bitmap;
+    r->disp = disp;
+    r->buffer = buffer;
+    r->scale = scale;
+    // the buffer is scaled as a whole at end of frame, drawing into it needs no view.
+    al_identity_transform(&r->view);
+    r->offscreen = false;
+    memset(&r->total, 0, sizeof(RenderStats));
+    memset(&r->frame, 0, sizeof(RenderStats));
+    r->first_frame_time = 0;
+    r->last_frame_time = 0;
+    return 0;
+}
+
+int renderer_init_allegro_direct(Renderer* r, ALLEGRO_DISPLAY* disp, float scale)
+{
+    r->begin_frame = _allegro_direct_begin_frame;
+    r->end_frame = _allegro_direct_end_frame;
+    r->use_transform = _allegro_use_transform;
+    r->line = _allegro_line;
+    r->filled_rectangle = _allegro_filled_rectangle;
+    r->triangles = _allegro_triangles;
+    r->text = _allegro_text;
+    r->create_bitmap = _allegro_create_bitmap;
+    r->destroy_bitmap = _allegro_destroy_bitmap;
+    r->begin_offscreen = _allegro_begin_offscreen;
+    r->end_offscreen = _allegro_end_offscreen;
+    r->bitmap = _allegro_bitmap;
+    r->disp = disp;
+    r->buffer = NULL;
+    r->scale = scale;
+    al_identity_transform(&r->view);
+    al_scale_transform(&r->view, scale, scale);
+    r->offscreen = false;
+    memset(&r->total, 0, sizeof(RenderStats));
+    memset(&r->frame, 0, sizeof(RenderStats));
+    r->first_frame_time = 0;
+    r->last_frame_time = 0;
+    return 0;
+}
+
+int renderer_init_null(Renderer* r)
+{
+    r->begin_frame = _null_begin_frame;
+    r->end_frame = _null_end_frame;
+    r->use_transform = _null_use_transform;
+    r->line = _null_line;
+    r->filled_rectangle = _null_filled_rectangle;
+    r->triangles = _null_triangles;
+    r->text = _null_text;
+    r->create_bitmap = _null_create_bitmap;
+    r->destroy_bitmap = _null_destroy_bitmap;
+    r->begin_offscreen = _null_begin_offscreen;
+    r->end_offscreen = _null_end_offscreen;
+    r->bitmap = _null_bitmap;
+    r->disp = NULL;
+    r->buffer = NULL;
+    r->scale = 1;
+    al_identity_transform(&r->view);
+    r->offscreen = false;
+    memset(&r->total, 0, sizeof(RenderStats));
+    memset(&r->frame, 0, sizeof(RenderStats));
+    r->first_frame_time = 0;
+    r->last_frame_time = 0;
+    return 0;
+}
+
+int renderer_destroy(Renderer* r)
+{
+    // display and buffer belong to whoever created them.
+    free(r);
+    return 0;
+}
+
+/*
+ What the game draws with, count then pass to backend.
+ */
+
+int render_begin_frame(Renderer* r, ALLEGRO_COLOR clear_color)
+{
+    r->last_frame_time = al_get_time();
+    if (r->total.frames == 0) {
+        r->first_frame_time = r->last_frame_time;
+    }
+    memset(&r->frame, 0, sizeof(RenderStats));
+    return r->begin_frame(r, clear_color);
+}
+
+int render_end_frame(Renderer* r)
+{
+    r->frame.frames = 1;
+    r->total.frames += r->frame.frames;
+    r->total.draw_calls += r->frame.draw_calls;
+    r->total.lines += r->frame.lines;
+    r->total.triangles += r->frame.triangles;
+    r->total.rectangles += r->frame.rectangles;
+    r->total.texts += r->frame.texts;
+    r->total.bitmaps += r->frame.bitmaps;
+    return r->end_frame(r);
+}
+
+int render_use_transform(Renderer* r, const ALLEGRO_TRANSFORM* transform)
+{
+    return r->use_transform(r, transform);
+}
+
+int render_line(Renderer* r, float x1, float y1, float x2, float y2, ALLEGRO_COLOR color, float thickness)
+{
+    r->frame.draw_calls++;
+    r->frame.lines++;
+    return r->line(r, x1, y1, x2, y2, color, thickness);
+}
+
+int render_filled_rectangle(Renderer* r, float x1, float y1, float x2, float y2, ALLEGRO_COLOR color)
+{
+    r->frame.draw_calls++;
+    r->frame.rectangles++;
+    return r->filled_rectangle(r, x1, y1, x2, y2, color);
+}
+
+int render_triangles(Renderer* r, const ALLEGRO_VERTEX* vertices, int vertex_count)
+{
+    r->frame.draw_calls++;
+    r->frame.triangles += vertex_count / 3;
+    return r->triangles(r, vertices, vertex_count);
+}
+
+int render_text(Renderer* r, const ALLEGRO_FONT* font, ALLEGRO_COLOR color, float x, float y, int flags, const char* text)
+{
+    r->frame.draw_calls++;
+    r->frame.texts++;
+    return r->text(r, font, color, x, y, flags, text);
+}
+
+ALLEGRO_BITMAP* render_create_bitmap(Renderer* r, int width, int height)
+{
+    return r->create_bitmap(r, width, height);
+}
+
+int render_destroy_bitmap(Renderer* r, ALLEGRO_BITMAP* bitmap)
+{
+    if (!bitmap) {
+        return 0;
+    }
+    return r->destroy_bitmap(r, bitmap);
+}
+
+int render_begin_offscreen(Renderer* r, ALLEGRO_BITMAP* bitmap)
+{
+    if (!bitmap) {
+        return 0;
+    }
+    return r->begin_offscreen(r, bitmap);
+}
+
+int render_end_offscreen(Renderer* r)
+{
+    return r->end_offscreen(r);
+}
+
+int render_bitmap(Renderer* r, ALLEGRO_BITMAP* bitmap, float x, float y)
+{
+    r->frame.draw_calls++;
+    r->frame.bitmaps++;
+    if (!bitmap) {
+        return 0;
+    }
+    return r->bitmap(r, bitmap, x, y);
+}
+
+int renderer_print_stats(Renderer* r)
+{
+    double frames = r->total.frames > 0 ? r->total.frames : 1;
+    printf("render: %ld frames, per frame: draw calls %.1f, lines %.1f, triangles %.1f, rectangles %.1f, texts %.1f, bitmaps %.1f\n",
+           r->total.frames,
+           r->total.draw_calls / frames,
+           r->total.lines / frames,
+           r->total.triangles / frames,
+           r->total.rectangles / frames,
+           r->total.texts / frames,
+           r->total.bitmaps / frames);
+    // wall clock, so it's only meaningful when the frames come at the render rate, not headless.
+    double seconds = r->last_frame_time - r->first_frame_time;
+    printf("render: text rasterizations %ld, %.1f per second\n", r->total.texts, seconds > 0 ? r->total.texts / seconds : 0);
+    return 0;
+}
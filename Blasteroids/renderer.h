@@ -0,0 +1,131 @@
+//
+//  renderer.h
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/04.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+/*
+ Renderer, what the game draws with, instead of calling Allegro's draw functions directly.
+ 
+ It's a table of backend functions, the game only calls the render_xxx() ones below, they count what's drawn then pass it to the backend.
+ Backends:
+    allegro -- draws into the buffer bitmap, then scales it to the display at end of frame.
+    allegro direct -- draws straight into the display's backbuffer, everything goes through a global scale transform (view). No buffer, no blit, no target switch at end of frame.
+    null    -- draws nothing, needs no display. Only the counts are kept, it's for headless runs and profiling the sim.
+ 
+ Transforms, colors and fonts are still Allegro's types, they are plain data, building them needs no display.
+ 
+ Offscreen bitmaps: things that seldom change (HUD, see hud_cache.h) are drawn once into a bitmap of their own, between render_begin_offscreen() and render_end_offscreen(), then only the bitmap is drawn every frame. The null backend has no bitmaps, create gives NULL, what's drawn into it is still counted.
+ */
+
+#ifndef renderer_h
+#define renderer_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <allegro5/allegro5.h>
+#include <allegro5/allegro_font.h>
+#include <allegro5/allegro_primitives.h>
+
+/*
+ What's been drawn, counted the same for every backend.
+ */
+typedef struct {
+    long frames;
+    long draw_calls;    // every render_xxx() call that draws something.
+    long lines;
+    long triangles;
+    long rectangles;
+    long texts;     // every one is a text rasterization, the glyphs drawn one by one.
+    long bitmaps;
+} RenderStats;
+
+typedef struct Renderer {
+    // backend functions.
+    int (*begin_frame)(struct Renderer* r, ALLEGRO_COLOR clear_color);
+    int (*end_frame)(struct Renderer* r);
+    int (*use_transform)(struct Renderer* r, const ALLEGRO_TRANSFORM* transform);
+    int (*line)(struct Renderer* r, float x1, float y1, float x2, float y2, ALLEGRO_COLOR color, float thickness);
+    int (*filled_rectangle)(struct Renderer* r, float x1, float y1, float x2, float y2, ALLEGRO_COLOR color);
+    int (*triangles)(struct Renderer* r, const ALLEGRO_VERTEX* vertices, int vertex_count);
+    int (*text)(struct Renderer* r, const ALLEGRO_FONT* font, ALLEGRO_COLOR color, float x, float y, int flags, const char* text);
+    ALLEGRO_BITMAP* (*create_bitmap)(struct Renderer* r, int width, int height);
+    int (*destroy_bitmap)(struct Renderer* r, ALLEGRO_BITMAP* bitmap);
+    int (*begin_offscreen)(struct Renderer* r, ALLEGRO_BITMAP* bitmap);
+    int (*end_offscreen)(struct Renderer* r);
+    int (*bitmap)(struct Renderer* r, ALLEGRO_BITMAP* bitmap, float x, float y);
+    // allegro backend: draw into buffer, show on display. buffer is NULL when drawing direct.
+    ALLEGRO_DISPLAY* disp;
+    ALLEGRO_BITMAP* buffer;
+    float scale;    // display px per buffer px.
+    ALLEGRO_TRANSFORM view;     // applied after every transform, identity unless drawing direct.
+    bool offscreen;     // drawing into an offscreen bitmap, in its own px, the view doesn't apply.
+    RenderStats total;
+    RenderStats frame;  // of the frame being drawn, folded into total at end of frame.
+    double first_frame_time;    // al_get_time() at the first and the latest frame, for per second stats.
+    double last_frame_time;
+} Renderer;
+
+/*
+ Backends.
+ */
+int renderer_init_allegro(Renderer* r, ALLEGRO_DISPLAY* disp, ALLEGRO_BITMAP* buffer, float scale);
+
+int renderer_init_allegro_direct(Renderer* r, ALLEGRO_DISPLAY* disp, float scale);
+
+int renderer_init_null(Renderer* r);
+
+int renderer_destroy(Renderer* r);
+
+/*
+ What the game draws with.
+ */
+
+/*
+ Start a frame, cleared to clear_color.
+ */
+int render_begin_frame(Renderer* r, ALLEGRO_COLOR clear_color);
+
+/*
+ Frame done, show it.
+ */
+int render_end_frame(Renderer* r);
+
+int render_use_transform(Renderer* r, const ALLEGRO_TRANSFORM* transform);
+
+int render_line(Renderer* r, float x1, float y1, float x2, float y2, ALLEGRO_COLOR color, float thickness);
+
+int render_filled_rectangle(Renderer* r, float x1, float y1, float x2, float y2, ALLEGRO_COLOR color);
+
+/*
+ A triangle list, vertex_count / 3 triangles, in one draw call.
+ */
+int render_triangles(Renderer* r, const ALLEGRO_VERTEX* vertices, int vertex_count);
+
+int render_text(Renderer* r, const ALLEGRO_FONT* font, ALLEGRO_COLOR color, float x, float y, int flags, const char* text);
+
+/*
+ A transparent bitmap of width x height to draw into, NULL on the null backend.
+ */
+ALLEGRO_BITMAP* render_create_bitmap(Renderer* r, int width, int height);
+
+int render_destroy_bitmap(Renderer* r, ALLEGRO_BITMAP* bitmap);
+
+/*
+ Draw into bitmap from now on, it's cleared to transparent first. Until render_end_offscreen(), then it's the frame again.
+ */
+int render_begin_offscreen(Renderer* r, ALLEGRO_BITMAP* bitmap);
+
+int render_end_offscreen(Renderer* r);
+
+/*
+ Draw bitmap with its top left at x, y, under identity transform.
+ */
+int render_bitmap(Renderer* r, ALLEGRO_BITMAP* bitmap, float x, float y);
+
+int renderer_print_stats(Renderer* r);
+
+
+#endif /* renderer_h */
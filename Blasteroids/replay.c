@@ -0,0 +1,229 @@
+//
+//  replay.c
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/06.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+#include "replay.h"
+#include <stdlib.h>
+#include <string.h>
+#include "common.h"
+
+#define REPLAY_MAGIC "BLRP"
+// mask in low 5 bits, run length - 1 in high 3 bits.
+#define REPLAY_MASK_BITS 0x1f
+#define REPLAY_RUN_SHIFT 5
+#define REPLAY_SHORT_RUN_MAX 7
+
+/*
+ Little endian read/write, so a file recorded on one machine plays on any other.
+ */
+int _replay_put(Replay* replay, uint64_t value, int size)
+{
+    for (int i = 0; i < size; i++) {
+        fputc((int)((value >> (8 * i)) & 0xff), replay->file);
+    }
+    replay->bytes += size;
+    return 0;
+}
+
+uint64_t _replay_get(Replay* replay, int size)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < size; i++) {
+        int c = fgetc(replay->file);
+        if (c == EOF) {
+            go_error("Replay file is cut short.");
+        }
+        value |= (uint64_t)c << (8 * i);
+    }
+    return value;
+}
+
+/*
+ Write the run recorded so far.
+ */
+int _replay_write_run(Replay* replay)
+{
+    if (replay->run_left == 0) {
+        return 0;
+    }
+    long extra = replay->run_left - 1;
+    if (extra < REPLAY_SHORT_RUN_MAX) {
+        _replay_put(replay, replay->run_mask | (extra << REPLAY_RUN_SHIFT), 1);
+    }
+    else {
+        _replay_put(replay, replay->run_mask | (REPLAY_SHORT_RUN_MAX << REPLAY_RUN_SHIFT), 1);
+        // varint of the rest.
+        unsigned long rest = (unsigned long)(extra - REPLAY_SHORT_RUN_MAX);
+        do {
+            unsigned char byte = rest & 0x7f;
+            rest >>= 7;
+            _replay_put(replay, byte | (rest ? 0x80 : 0), 1);
+        } while (rest);
+    }
+    replay->run_left = 0;
+    return 0;
+}
+
+/*
+ Read the next run, return 1 if there's none.
+ */
+int _replay_read_run(Replay* replay)
+{
+    int c = fgetc(replay->file);
+    if (c == EOF) {
+        replay->finished = true;
+        return 1;
+    }
+    replay->run_mask = c & REPLAY_MASK_BITS;
+    long extra = c >> REPLAY_RUN_SHIFT;
+    if (extra == REPLAY_SHORT_RUN_MAX) {
+        unsigned long rest = 0;
+        int shift = 0;
+        int byte;
+        do {
+            byte = (int)_replay_get(replay, 1);
+            rest |= (unsigned long)(byte & 0x7f) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+        extra += rest;
+    }
+    replay->run_left = extra + 1;
+    return 0;
+}
+
+int replay_init(Replay* replay)
+{
+    replay->mode = REPLAY_OFF;
+    replay->file = NULL;
+    replay->seed = 0;
+    replay->sim_hz = 0;
+    replay->weapon_cooldown = 0;
+    replay->blast_lifetime = 0;
+    replay->run_mask = 0;
+    replay->run_left = 0;
+    replay->finished = false;
+    replay->ticks = 0;
+    replay->bytes = 0;
+    return 0;
+}
+
+int replay_destroy(Replay* replay)
+{
+    if (replay->mode == REPLAY_RECORD) {
+        _replay_write_run(replay);
+    }
+    if (replay->file) {
+        fclose(replay->file);
+    }
+    free(replay);
+    return 0;
+}
+
+/*
+ A float as it is in memory, so it's written and read back exactly.
+ */
+uint32_t _replay_float_bits(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, 4);
+    return bits;
+}
+
+float _replay_bits_float(uint32_t bits)
+{
+    float value;
+    memcpy(&value, &bits, 4);
+    return value;
+}
+
+int replay_start_recording(Replay* replay, const char* path, uint64_t seed, float sim_hz, float weapon_cooldown, float blast_lifetime)
+{
+    replay->file = fopen(path, "wb");
+    if (!replay->file) {
+        go_error("Failed to create the replay file.");
+    }
+    replay->mode = REPLAY_RECORD;
+    replay->seed = seed;
+    replay->sim_hz = sim_hz;
+    replay->weapon_cooldown = weapon_cooldown;
+    replay->blast_lifetime = blast_lifetime;
+    fwrite(REPLAY_MAGIC, 1, 4, replay->file);
+    replay->bytes += 4;
+    _replay_put(replay, REPLAY_VERSION, 4);
+    _replay_put(replay, seed, 8);
+    _replay_put(replay, (uint64_t)(sim_hz * 1000 + 0.5f), 4);
+    _replay_put(replay, _replay_float_bits(weapon_cooldown), 4);
+    _replay_put(replay, _replay_float_bits(blast_lifetime), 4);
+    return 0;
+}
+
+int replay_record(Replay* replay, unsigned char mask)
+{
+    mask &= REPLAY_MASK_BITS;
+    if (replay->run_left > 0 && mask != replay->run_mask) {
+        _replay_write_run(replay);
+    }
+    replay->run_mask = mask;
+    replay->run_left++;
+    replay->ticks++;
+    return 0;
+}
+
+int replay_start_playing(Replay* replay, const char* path)
+{
+    replay->file = fopen(path, "rb");
+    if (!replay->file) {
+        go_error("Failed to open the replay file.");
+    }
+    replay->mode = REPLAY_PLAY;
+    char magic[4];
+    if (fread(magic, 1, 4, replay->file) != 4 || memcmp(magic, REPLAY_MAGIC, 4) != 0) {
+        go_error("Not a replay file.");
+    }
+    if (_replay_get(replay, 4) != REPLAY_VERSION) {
+        go_error("Replay file of another version.");
+    }
+    replay->seed = _replay_get(replay, 8);
+    replay->sim_hz = _replay_get(replay, 4) / 1000.0f;
+    replay->weapon_cooldown = _replay_bits_float((uint32_t)_replay_get(replay, 4));
+    replay->blast_lifetime = _replay_bits_float((uint32_t)_replay_get(replay, 4));
+    return 0;
+}
+
+int replay_play(Replay* replay, unsigned char* mask)
+{
+    if (replay->run_left == 0 && _replay_read_run(replay)) {
+        return 1;
+    }
+    *mask = replay->run_mask;
+    replay->run_left--;
+    replay->ticks++;
+    return 0;
+}
+
+int replay_apply(Replay* replay, unsigned char* mask)
+{
+    if (replay->mode == REPLAY_PLAY) {
+        return replay_play(replay, mask);
+    }
+    if (replay->mode == REPLAY_RECORD) {
+        replay_record(replay, *mask);
+    }
+    return 0;
+}
+
+int replay_print_stats(Replay* replay)
+{
+    if (replay->mode == REPLAY_RECORD) {
+        // the last run is still in memory, it's 1 byte or a few more.
+        printf("replay: recorded %ld ticks in %ld bytes\n", replay->ticks, replay->bytes);
+    }
+    else if (replay->mode == REPLAY_PLAY) {
+        printf("replay: played %ld ticks%s\n", replay->ticks, replay->finished ? ", to the end" : "");
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+//
+//  replay.h
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/06.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+/*
+ Record and replay a whole session, as its input.
+ 
+ The sim is deterministic: same seed, same sim rate, same input each tick, gives the same game. So a session is just its header and one input mask per tick.
+ 
+ File layout, all little endian:
+    header: "BLRP", version (u32), seed (u64), sim rate in milli Hz (u32), weapon cooldown and blast lifetime in seconds (f32 bits each, exact, they decide when blasts come and go).
+    ticks:  run length encoded input masks. Each run is one byte: mask in bits 0-4, run length - 1 in bits 5-7.
+            Run length - 1 == 7 means a longer run, the rest (run length - 8) follows as a varint, 7 bits per byte, low bits first, high bit set == more bytes.
+ Holding a key for a while, or not touching anything, is only a few bytes.
+ */
+
+#ifndef replay_h
+#define replay_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// 2: hits are resolved by entity handle, a session recorded before plays out differently.
+// 3: the weapon settings are in the header.
+// 4: a blast fired is in the air from the end of run_game_logic(), hit tested from the next tick on.
+#define REPLAY_VERSION 4
+
+typedef enum {
+    REPLAY_OFF,
+    REPLAY_RECORD,
+    REPLAY_PLAY
+} ReplayMode;
+
+typedef struct {
+    ReplayMode mode;
+    FILE* file;
+    // from the header.
+    uint64_t seed;
+    float sim_hz;
+    float weapon_cooldown;  // in seconds.
+    float blast_lifetime;
+    // the run being recorded, or being played back.
+    unsigned char run_mask;
+    long run_left;      // play: ticks left of this run. record: ticks in this run so far.
+    bool finished;      // play: no more ticks in the file.
+    // stats
+    long ticks;
+    long bytes;
+} Replay;
+
+int replay_init(Replay* replay);
+
+/*
+ Close the file, a recording gets its last run written first.
+ */
+int replay_destroy(Replay* replay);
+
+/*
+ Create the file at path and write the header.
+ */
+int replay_start_recording(Replay* replay, const char* path, uint64_t seed, float sim_hz, float weapon_cooldown, float blast_lifetime);
+
+/*
+ Record the input of one tick.
+ */
+int replay_record(Replay* replay, unsigned char mask);
+
+/*
+ Open the file at path and read the header, the game should be started with replay->seed, replay->sim_hz and the weapon settings of it.
+ */
+int replay_start_playing(Replay* replay, const char* path);
+
+/*
+ Input of the next tick into mask.
+ Return 0 if there's one, 1 if the recording is over.
+ */
+int replay_play(Replay* replay, unsigned char* mask);
+
+/*
+ The input of one tick goes through the replay: recorded when recording, replaced by the recorded one when playing.
+ Return 1 if the recording being played is over, the session should end, 0 otherwise.
+ */
+int replay_apply(Replay* replay, unsigned char* mask);
+
+int replay_print_stats(Replay* replay);
+
+
+#endif /* replay_h */
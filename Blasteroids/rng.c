@@ -0,0 +1,69 @@
+//
+//  rng.c
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/05.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+#include "rng.h"
+#include <stdlib.h>
+
+// the stream all games use, only the seed tells them apart.
+#define RNG_DEFAULT_STREAM 0xda3e39cb94b95bdbULL
+
+int rng_seed(Rng* rng, uint64_t seed)
+{
+    // the reference pcg32_srandom_r().
+    rng->state = 0;
+    rng->inc = (RNG_DEFAULT_STREAM << 1) | 1;
+    rng_next(rng);
+    rng->state += seed;
+    rng_next(rng);
+    return 0;
+}
+
+int rng_destroy(Rng* rng)
+{
+    free(rng);
+    return 0;
+}
+
+uint32_t rng_next(Rng* rng)
+{
+    uint64_t old = rng->state;
+    rng->state = old * 6364136223846793005ULL + rng->inc;
+    uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+    uint32_t rot = (uint32_t)(old >> 59);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+float rng_float(Rng* rng, float lo, float hi)
+{
+    // top 24 bits, exactly what a float holds, so it never rounds up to 1.
+    float unit = (rng_next(rng) >> 8) * (1.0f / 16777216.0f);
+    return lo + unit * (hi - lo);
+}
+
+int rng_int(Rng* rng, int lo, int hi)
+{
+    // multiply and keep the high half, no modulo.
+    uint32_t range = (uint32_t)(hi - lo);
+    return lo + (int)(((uint64_t)rng_next(rng) * range) >> 32);
+}
+
+int rng_fill_float(Rng* rng, float* out, int count, float lo, float hi)
+{
+    for (int i = 0; i < count; i++) {
+        out[i] = rng_float(rng, lo, hi);
+    }
+    return 0;
+}
+
+int rng_fill_int(Rng* rng, int* out, int count, int lo, int hi)
+{
+    for (int i = 0; i < count; i++) {
+        out[i] = rng_int(rng, lo, hi);
+    }
+    return 0;
+}
@@ -0,0 +1,51 @@
+//
+//  rng.h
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/05.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+/*
+ Random number generator, PCG32 (pcg-random.org).
+ 
+ Each game owns one, nothing is shared, so games could run side by side, each on its own thread.
+ The same seed gives the same numbers in the same order, on every run and every platform, so the same seed gives the same levels.
+ */
+
+#ifndef rng_h
+#define rng_h
+
+#include <stdio.h>
+#include <stdint.h>
+
+typedef struct {
+    uint64_t state;
+    uint64_t inc;   // stream, always odd.
+} Rng;
+
+int rng_seed(Rng* rng, uint64_t seed);
+
+int rng_destroy(Rng* rng);
+
+/*
+ Next 32 random bits.
+ */
+uint32_t rng_next(Rng* rng);
+
+/*
+ Uniform in [lo, hi).
+ */
+float rng_float(Rng* rng, float lo, float hi);
+
+int rng_int(Rng* rng, int lo, int hi);
+
+/*
+ Batch: fill out[0, count) with uniform numbers in [lo, hi), the same as calling the one by one version count times.
+ */
+int rng_fill_float(Rng* rng, float* out, int count, float lo, float hi);
+
+int rng_fill_int(Rng* rng, int* out, int count, int lo, int hi);
+
+
+#endif /* rng_h */
@@ -8,6 +8,7 @@
 
 
 #include "score.h"
+#include <math.h>
 
 int score_init(Score* s)
 {
@@ -15,22 +16,27 @@ int score_init(Score* s)
     s->x = SCORE_POSITION_X;
     s->y = SCORE_POSITION_Y;
     s->size_factor = SCORE_SCALE;
-    s->font = al_create_builtin_font();
     s->color = (al_map_rgb(238, 130, 177));
     return 0;
 }
 
-int score_draw(Score* s)
+int score_draw(Score* s, Renderer* r, ALLEGRO_FONT* font, HudCache* cache)
 {
-    // draw code goes here.
-    // set transform, where to put the score
-    ALLEGRO_TRANSFORM transform;
-    al_identity_transform(&transform);
-    // which comes first which comes late matters.
-    al_scale_transform(&transform, s->size_factor, s->size_factor);   // scale-x, scale-y
-    al_translate_transform(&transform, s->x, s->y);   // move to position-x,y
-    al_use_transform(&transform);
-    al_draw_textf(s->font, s->color, s->x, s->y, 0, "%d", s->score);
+    char text[16];
+    snprintf(text, sizeof(text), "%d", s->score);
+    int width = (int)ceilf(al_get_text_width(font, text) * s->size_factor);
+    int height = (int)ceilf(al_get_font_line_height(font) * s->size_factor);
+    if (hud_cache_begin(cache, r, text, width, height)) {
+        // score changed, draw the text into the cache, scaled.
+        ALLEGRO_TRANSFORM transform;
+        al_identity_transform(&transform);
+        al_scale_transform(&transform, s->size_factor, s->size_factor);   // scale-x, scale-y
+        render_use_transform(r, &transform);
+        render_text(r, font, s->color, 0, 0, 0, text);
+        hud_cache_end(cache, r);
+    }
+    // the same place it always was: the text at x,y, scaled, then moved by x,y.
+    hud_cache_draw(cache, r, s->x * s->size_factor + s->x, s->y * s->size_factor + s->y);
     return 0;
 }
 
@@ -46,7 +52,7 @@ int score_change(Score* s, int s_delta)
 
 int score_destroy(Score* s)
 {
-    //free(s->font);    // don't know why but this will be freed before this...
+    // the font is the one shared by everything, not the score's.
     free(s);
     return 0;
 }
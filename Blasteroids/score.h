@@ -18,14 +18,16 @@
 typedef struct {
     int score;
     ALLEGRO_COLOR color;
-    ALLEGRO_FONT* font;
     float x,y;
     float size_factor;
 } Score;
 
 int score_init(Score* s);
 
-int score_draw(Score* s);
+/*
+ Draw the score with font, through cache, the text is only drawn again when the score changes.
+ */
+int score_draw(Score* s, Renderer* r, ALLEGRO_FONT* font, HudCache* cache);
 
 int score_change(Score* s, int s_delta);
 
@@ -0,0 +1,173 @@
+//
+//  sim_thread.c
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/10.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+#include "sim_thread.h"
+#include "trace.h"
+
+// set on middle when the slot in it is newer than front.
+#define SIM_SLOT_FRESH 4
+#define SIM_SLOT_INDEX 3
+
+/*
+ Consumer: OR of every mask pushed since the last step, so a tap between two steps isn't missed. Nothing pushed: the keys are as they were.
+ */
+unsigned char _sim_input_pop_all(SimThread* sim)
+{
+    SimInputQueue* queue = &sim->input;
+    unsigned int head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    if (head == tail) {
+        return sim->last_mask;
+    }
+    unsigned char mask = 0;
+    while (head != tail) {
+        mask |= queue->masks[head % SIM_INPUT_QUEUE_SIZE];
+        // the latest one stays held next step, if nothing newer comes.
+        sim->last_mask = queue->masks[head % SIM_INPUT_QUEUE_SIZE];
+        head++;
+    }
+    atomic_store_explicit(&queue->head, head, memory_order_release);
+    return mask;
+}
+
+/*
+ Sim thread: save the game into back, swap it into middle, take the old middle as the next back.
+ */
+void _sim_thread_publish(SimThread* sim, double time)
+{
+    snapshot_save(sim->slots[sim->back], sim->game);
+    sim->slot_time[sim->back] = time;
+    sim->back = atomic_exchange(&sim->middle, sim->back | SIM_SLOT_FRESH) & SIM_SLOT_INDEX;
+    sim->snapshots_published++;
+}
+
+void* _sim_thread_main(void* arg)
+{
+    SimThread* sim = arg;
+    trace_set_thread(2);
+    double last_time = al_get_time();
+    double accumulator = 0;
+    while (!atomic_load(&sim->quit)) {
+        // the same fixed step clock as the single thread loop.
+        double now = al_get_time();
+        double frame_time = now - last_time;
+        last_time = now;
+        accumulator += frame_time > MAX_FRAME_TIME ? MAX_FRAME_TIME : frame_time;
+        int steps = 0;
+        while (accumulator >= sim->dt && !atomic_load(&sim->quit)) {
+            unsigned char mask = _sim_input_pop_all(sim);
+            if (replay_apply(sim->replay, &mask)) {
+                // the recording is over, so is the session.
+                atomic_store(&sim->finished, true);
+                atomic_store(&sim->quit, true);
+                break;
+            }
+            uint64_t t = trace_begin();
+            game_step(sim->game, mask, sim->dt);
+            trace_end("sim_step", t);
+            atomic_fetch_add(&sim->sim_steps, 1);
+            accumulator -= sim->dt;
+            steps++;
+        }
+        if (steps) {
+            uint64_t t = trace_begin();
+            _sim_thread_publish(sim, al_get_time());
+            trace_end("snapshot_publish", t);
+        }
+        // nothing to do till the next step is due. Fallen behind (or quitting with steps left), it's due already, no rest.
+        double wait = sim->dt - accumulator;
+        if (wait > 0) {
+            al_rest(wait);
+        }
+    }
+    return NULL;
+}
+
+int sim_thread_start(SimThread* sim, GAME_INSTANCE* game, Replay* replay, float dt)
+{
+    sim->game = game;
+    sim->replay = replay;
+    sim->dt = dt;
+    for (int s = 0; s < 3; s++) {
+        sim->slots[s] = malloc(sizeof(Snapshot));
+        snapshot_init(sim->slots[s]);
+        sim->slot_time[s] = 0;
+    }
+    sim->back = 0;
+    sim->front = 1;
+    atomic_init(&sim->middle, 2);
+    atomic_init(&sim->input.head, 0);
+    atomic_init(&sim->input.tail, 0);
+    sim->input.dropped = 0;
+    sim->last_mask = 0;
+    atomic_init(&sim->quit, false);
+    atomic_init(&sim->finished, false);
+    atomic_init(&sim->sim_steps, 0);
+    sim->snapshots_published = 0;
+    sim->snapshots_consumed = 0;
+    
+    // so the render thread has something to draw from the very first frame.
+    _sim_thread_publish(sim, al_get_time());
+    if (pthread_create(&sim->thread, NULL, _sim_thread_main, sim) != 0) {
+        go_error("Failed when starting sim thread.");
+    }
+    return 0;
+}
+
+int sim_thread_stop(SimThread* sim)
+{
+    atomic_store(&sim->quit, true);
+    pthread_join(sim->thread, NULL);
+    return 0;
+}
+
+int sim_thread_destroy(SimThread* sim)
+{
+    for (int s = 0; s < 3; s++) {
+        snapshot_destroy(sim->slots[s]);
+    }
+    free(sim);
+    return 0;
+}
+
+int sim_thread_push_input(SimThread* sim, unsigned char mask)
+{
+    SimInputQueue* queue = &sim->input;
+    unsigned int tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    unsigned int head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    if (tail - head == SIM_INPUT_QUEUE_SIZE) {
+        // the sim is way behind, it has the keys of a second ago to catch up with anyway.
+        queue->dropped++;
+        return 1;
+    }
+    queue->masks[tail % SIM_INPUT_QUEUE_SIZE] = mask;
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return 0;
+}
+
+Snapshot* sim_thread_latest(SimThread* sim, bool* fresh, double* time)
+{
+    *fresh = atomic_load(&sim->middle) & SIM_SLOT_FRESH;
+    if (*fresh) {
+        // take the new one, leave the old front for the sim to write.
+        sim->front = atomic_exchange(&sim->middle, sim->front) & SIM_SLOT_INDEX;
+        sim->snapshots_consumed++;
+    }
+    *time = sim->slot_time[sim->front];
+    return sim->slots[sim->front];
+}
+
+int sim_thread_print_stats(SimThread* sim)
+{
+    printf("sim thread: %ld steps, snapshots published %ld, drawn %ld, input dropped %ld\n",
+           (long)atomic_load(&sim->sim_steps),
+           sim->snapshots_published,
+           sim->snapshots_consumed,
+           sim->input.dropped);
+    return 0;
+}
@@ -0,0 +1,95 @@
+//
+//  sim_thread.h
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/10.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+/*
+ The simulation on its own thread, so a slow flip of the display never holds up the game.
+ 
+ The sim thread owns the game: it runs fixed steps on its own clock, and after each batch of steps publishes a snapshot of the world (snapshot.h) into a triple buffer.
+ The render thread takes the latest published snapshot, restores it into a game of its own only used for drawing, and draws that. Neither thread ever waits for the other:
+    - triple buffer: the sim writes the back slot, the render thread reads the front slot, the middle slot is swapped with either of them with one atomic exchange.
+    - input goes the other way through a single producer single consumer ring of input masks, the render thread pushes the keyboard's mask every frame, the sim takes them at each step.
+ 
+ The sim thread doesn't touch anything of Allegro except the clock, the render thread doesn't touch the sim's game until the thread is stopped.
+ */
+
+#ifndef sim_thread_h
+#define sim_thread_h
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "game.h"
+#include "replay.h"
+#include "snapshot.h"
+
+// input masks the ring holds, a second of frames at 60 Hz.
+#define SIM_INPUT_QUEUE_SIZE 64
+
+/*
+ Single producer (render thread) single consumer (sim thread) ring of input masks.
+ */
+typedef struct {
+    unsigned char masks[SIM_INPUT_QUEUE_SIZE];
+    _Atomic unsigned int head;  // next to pop, only the consumer moves it.
+    _Atomic unsigned int tail;  // next to push, only the producer moves it.
+    long dropped;   // pushed while full, producer's.
+} SimInputQueue;
+
+typedef struct {
+    GAME_INSTANCE* game;    // the sim's, only touched by the sim thread while it runs.
+    Replay* replay;
+    float dt;
+    pthread_t thread;
+    
+    // triple buffer of snapshots. back: sim's, front: render thread's, middle: the one in between, with SIM_SLOT_FRESH set when it's newer than front.
+    Snapshot* slots[3];
+    double slot_time[3];    // al_get_time() of the step the slot was saved after.
+    int back;
+    int front;
+    _Atomic int middle;
+    
+    SimInputQueue input;
+    unsigned char last_mask;    // sim's, used again when no new input came.
+    
+    _Atomic bool quit;      // render thread asks the sim to stop.
+    _Atomic bool finished;  // the sim stopped by itself, the replay is over.
+    _Atomic long sim_steps;
+    long snapshots_published;
+    long snapshots_consumed;
+} SimThread;
+
+/*
+ Publish the game as it is, then start the sim thread on it. From now on game belongs to the thread, till sim_thread_stop().
+ */
+int sim_thread_start(SimThread* sim, GAME_INSTANCE* game, Replay* replay, float dt);
+
+/*
+ Ask the sim to stop and wait for it. game is the caller's again afterwards.
+ */
+int sim_thread_stop(SimThread* sim);
+
+/*
+ Free the snapshots and sim itself, after sim_thread_stop().
+ */
+int sim_thread_destroy(SimThread* sim);
+
+/*
+ Render thread: push the input mask of this frame.
+ */
+int sim_thread_push_input(SimThread* sim, unsigned char mask);
+
+/*
+ Render thread: the latest snapshot published, *fresh tells if it's newer than the one returned last time. *time is when it was saved.
+ */
+Snapshot* sim_thread_latest(SimThread* sim, bool* fresh, double* time);
+
+int sim_thread_print_stats(SimThread* sim);
+
+
+#endif /* sim_thread_h */
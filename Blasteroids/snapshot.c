@@ -0,0 +1,117 @@
+//
+//  snapshot.c
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/07.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+#include "snapshot.h"
+#include <string.h>
+
+// every part starts at this alignment, the same as a malloc'd block.
+#define SNAPSHOT_ALIGN 16
+
+size_t _snapshot_align(size_t offset)
+{
+    return (offset + SNAPSHOT_ALIGN - 1) & ~(size_t)(SNAPSHOT_ALIGN - 1);
+}
+
+int _snapshot_reserve(Snapshot* snapshot, size_t size)
+{
+    if (size <= snapshot->capacity) {
+        return 0;
+    }
+    size_t new_capacity = snapshot->capacity ? snapshot->capacity : 4096;
+    while (new_capacity < size) {
+        new_capacity *= 2;
+    }
+    snapshot->data = must_realloc(snapshot->data, new_capacity, "Failed when growing snapshot, out of memory.");
+    snapshot->capacity = new_capacity;
+    return 0;
+}
+
+int snapshot_init(Snapshot* snapshot)
+{
+    snapshot->data = NULL;
+    snapshot->size = 0;
+    snapshot->capacity = 0;
+    return 0;
+}
+
+int snapshot_destroy(Snapshot* snapshot)
+{
+    free(snapshot->data);
+    free(snapshot);
+    return 0;
+}
+
+int snapshot_save(Snapshot* snapshot, GAME_INSTANCE* game)
+{
+    AsteroidCluster* ac = game->all_asteroids;
+    int blast_count = game->all_blasts->count;
+
+    // 1. where everything goes.
+    size_t asteroid_offset = _snapshot_align(sizeof(SnapshotHeader));
+    size_t blast_offset = _snapshot_align(asteroid_offset + asteroid_cluster_packed_size(ac));
+    size_t particle_offset = _snapshot_align(blast_offset + blastcluster_packed_size(game->all_blasts));
+    size_t size = particle_offset + particle_pool_packed_size(game->particles);
+    _snapshot_reserve(snapshot, size);
+    snapshot->size = size;
+
+    // 2. header, the small things are copied as they are.
+    SnapshotHeader* header = (SnapshotHeader*)snapshot->data;
+    header->version = SNAPSHOT_VERSION;
+    header->size = (uint32_t)size;
+    header->ship = *game->ship;
+    header->level = *game->level;
+    header->score = game->score->score;
+    header->life_left = game->life_counter->life_left;
+    header->rng = *game->rng;
+    header->weapon = *game->weapon;
+    header->asteroid_count = ac->count;
+    header->asteroid_offset = (uint32_t)asteroid_offset;
+    header->asteroid_spin_time = ac->spin_time;
+    header->asteroid_last_dt = ac->last_dt;
+    header->blast_count = blast_count;
+    header->blast_offset = (uint32_t)blast_offset;
+    header->particle_rng = game->particles->rng;
+    header->particle_count = game->particles->count;
+    header->particle_offset = (uint32_t)particle_offset;
+
+    // 3. asteroids, array by array.
+    asteroid_cluster_pack(ac, snapshot->data + asteroid_offset);
+
+    // 4. blasts, the ring unrolled, oldest first.
+    blastcluster_pack(game->all_blasts, snapshot->data + blast_offset);
+
+    // 5. particles, array by array.
+    particle_pool_pack(game->particles, snapshot->data + particle_offset);
+    return 0;
+}
+
+int snapshot_restore(Snapshot* snapshot, GAME_INSTANCE* game)
+{
+    SnapshotHeader* header = (SnapshotHeader*)snapshot->data;
+    if (!header || header->version != SNAPSHOT_VERSION || header->size != snapshot->size) {
+        go_error("Not a snapshot of this version.");
+    }
+
+    *game->ship = header->ship;
+    *game->level = header->level;
+    game->score->score = header->score;
+    game->life_counter->life_left = header->life_left;
+    *game->rng = header->rng;
+    *game->weapon = header->weapon;
+
+    asteroid_cluster_unpack(game->all_asteroids, snapshot->data + header->asteroid_offset, header->asteroid_count);
+    game->all_asteroids->spin_time = header->asteroid_spin_time;
+    game->all_asteroids->last_dt = header->asteroid_last_dt;
+
+    // blasts go back into the ring from its start, in the same order.
+    blastcluster_unpack(game->all_blasts, snapshot->data + header->blast_offset, header->blast_count);
+
+    game->particles->rng = header->particle_rng;
+    particle_pool_unpack(game->particles, snapshot->data + header->particle_offset, header->particle_count);
+    return 0;
+}
@@ -0,0 +1,74 @@
+//
+//  snapshot.h
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/07.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+/*
+ Snapshot of the whole game world, in one flat buffer.
+ 
+ Layout:
+    header  -- ship, level, score, lives, rng, weapon, and where the rest is, as offsets from the start of the buffer. No pointers, so the buffer could be copied around, or written to a file as is.
+    asteroids -- the asteroid arrays, only the part in use of each, one after another, then their handle table.
+    blasts  -- every blast, one after another, oldest first, then their cold arrays, then their handle table.
+    particles -- the particle arrays, only the live ones, oldest first.
+ 
+ What's rebuilt every tick (broadphase grid, sweep and prune) is not in it. The handle tables are: hits are resolved by handle, so they're part of what decides the game.
+ 
+ Restore copies the header back, the asteroid arrays one copy each, and the blasts back into the ring in one copy, so rollback or save/load never walks anything deep.
+ The buffer only grows, after the first few saves there's no more heap calls.
+ */
+
+#ifndef snapshot_h
+#define snapshot_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include "game.h"
+
+#define SNAPSHOT_VERSION 6
+
+typedef struct {
+    uint32_t version;
+    uint32_t size;  // of the whole snapshot, in bytes.
+    Spaceship ship;
+    Level level;
+    int score;
+    int life_left;
+    Rng rng;
+    Weapon weapon;
+    int asteroid_count;
+    uint32_t asteroid_offset;   // from the start of the snapshot.
+    double asteroid_spin_time;
+    float asteroid_last_dt;
+    int blast_count;
+    uint32_t blast_offset;
+    Rng particle_rng;
+    int particle_count;
+    uint32_t particle_offset;
+} SnapshotHeader;
+
+typedef struct {
+    unsigned char* data;
+    size_t size;
+    size_t capacity;
+} Snapshot;
+
+int snapshot_init(Snapshot* snapshot);
+
+int snapshot_destroy(Snapshot* snapshot);
+
+/*
+ Save the whole game into snapshot, what was in it is overwritten.
+ */
+int snapshot_save(Snapshot* snapshot, GAME_INSTANCE* game);
+
+/*
+ Put the game back to how it was when snapshot was saved.
+ */
+int snapshot_restore(Snapshot* snapshot, GAME_INSTANCE* game);
+
+
+#endif /* snapshot_h */
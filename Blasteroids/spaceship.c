@@ -18,11 +18,11 @@
         1.3 Position is calculated in float, cast to int on the fly when drawing.
     2. Speed and Acceleration:
         2.1 When the user is pressing UP, the speed of the spaceship increases; pressing DOWN, decreases.
-        2.2 The space ship moves with its current speed, distance moved should be calculated with (1/fps)*spd.
-        2.3 The acceleration per keypress, is a constant value. The max speed is also a constant value.
+        2.2 The space ship moves with its current speed, distance moved should be calculated with dt*spd, dt is the fixed sim step.
+        2.3 The acceleration per keypress, is a constant value per 1/GAME_FPS tick, scaled by the sim step. The max speed is also a constant value.
     3. Heading:
         3.1 heading is a float, between 0-1, 0 = 0 degree, 1 = 360 degree.
-        3.2 The rate heading turns, is a constant number, it's X degree per keypress event.
+        3.2 The rate heading turns, is a constant number, it's X degree per 1/GAME_FPS tick the key is held.
     4. Live and Die:
         4.1 When space ship is hit, the total life decreases by 1, when life == 0, GAME OVER
         4.2 When space ship just lost a life, it will become invincible for a short period of time, during this time, any hit will be ignored, (the asteroid should be destroyed if hit by ship in this state), and the space ship should be flashing.
@@ -33,6 +33,33 @@
 
 
 
+/*
+ Heading or speed just changed, redo the trig once.
+ 0 degree is north, screen y goes down, so it's -cos for y.
+ */
+int _spaceship_refresh_velocity(Spaceship *ship)
+{
+    ship->dir_x = sin(DEGTORAD(ship->heading));
+    ship->dir_y = -cos(DEGTORAD(ship->heading));
+    ship->vx = ship->speed * ship->dir_x;
+    ship->vy = ship->speed * ship->dir_y;
+    return 0;
+}
+
+/*
+ Position just changed, refresh the bounding box.
+ a spaceship takes a space of -8 to +8 in x, -11 to 9 in y, relative to it's x,y, rotation is too complicated, use a square of 11 instead.
+ */
+int _spaceship_refresh_bbox(Spaceship *ship)
+{
+    float offset = 11 * ship->scale;  // when scale, BBOX should apply this scale.
+    ship->min_x = ship->x - offset;
+    ship->min_y = ship->y - offset;
+    ship->max_x = ship->x + offset;
+    ship->max_y = ship->y + offset;
+    return 0;
+}
+
 /*
  Init the space ship.
  */
@@ -45,6 +72,9 @@ int spaceship_init(Spaceship *ship, float x, float y)
     ship->speed = 0.0;
     ship->invincible_time = 0;
     ship->color = al_map_rgb(35, 122, 22); // the exact color from the book.
+    _spaceship_refresh_velocity(ship);
+    _spaceship_refresh_bbox(ship);
+    spaceship_keep_previous(ship);
     return 0;
 }
 
@@ -55,9 +85,9 @@ int spaceship_reset_to_center(Spaceship *ship)
 }
 
 /*
- Draw the space ship, call allegro's draw directly.
+ Draw the space ship, through the renderer.
  */
-int spaceship_draw(Spaceship *ship)
+int spaceship_draw(Spaceship *ship, float alpha, Renderer* r)
 {
     // when it's invicible, it should flash. say, 4 times per second.
     if (fmod(ship->invincible_time, 1.0/SHIP_FLASH_FREQUENCY) > (1.0/SHIP_FLASH_FREQUENCY)/2.0) {
@@ -68,35 +98,44 @@ int spaceship_draw(Spaceship *ship)
         al_identity_transform(&transform);
         // which comes first which comes late matters.
         al_scale_transform(&transform, ship->scale, ship->scale);
-        al_rotate_transform(&transform, DEGTORAD(ship->heading));
-        al_translate_transform(&transform, ship->x, ship->y);
-        al_use_transform(&transform);
-        al_draw_line(-8, 9, 0, -11, ship->color, 3.0f);
-        al_draw_line(0, -11, 8, 9, ship->color, 3.0f);
-        al_draw_line(-6, 4, -1, 4, ship->color, 3.0f);
-        al_draw_line(6, 4, 1, 4, ship->color, 3.0f);
+        // in between last step and this one, the short way if it just went across an edge.
+        al_rotate_transform(&transform, DEGTORAD(lerp_f(ship->prev_heading, ship->heading, alpha)));
+        al_translate_transform(&transform, lerp_wrapped_f(ship->prev_x, ship->x, alpha, BUFFER_WIDTH), lerp_wrapped_f(ship->prev_y, ship->y, alpha, BUFFER_HEIGHT));
+        render_use_transform(r, &transform);
+        render_line(r, -8, 9, 0, -11, ship->color, 3.0f);
+        render_line(r, 0, -11, 8, 9, ship->color, 3.0f);
+        render_line(r, -6, 4, -1, 4, ship->color, 3.0f);
+        render_line(r, 6, 4, 1, 4, ship->color, 3.0f);
     }
     return 0;
 }
 
+int spaceship_keep_previous(Spaceship *ship)
+{
+    ship->prev_x = ship->x;
+    ship->prev_y = ship->y;
+    ship->prev_heading = ship->heading;
+    return 0;
+}
+
 /*
  Update the space ship's data, to apply the accelerations.
- It's supposed to be called within every timer event, so the space ship could move accordingly between draws.
+ It's supposed to be called once every sim step, dt seconds, so the space ship could move accordingly between draws.
  */
-int spaceship_update(Spaceship *ship)
+int spaceship_update(Spaceship *ship, float dt)
 {
     // decrease spaceship's invicible time, if it's positive.
-    ship->invincible_time = ship->invincible_time > 0 ? ship->invincible_time - 1.0/GAME_FPS : 0;
+    ship->invincible_time = ship->invincible_time > 0 ? ship->invincible_time - dt : 0;
     
-    // move forward the ship, with the distance traveled from last draw (should be 1/FPS seconds).
-    ship->x += ((ship->speed * (1.0/GAME_FPS)) * sin(DEGTORAD(ship->heading)));
-    // screen coordinates's y is opposite from traditional ones in math.
-    ship->y -= ((ship->speed * (1.0/GAME_FPS)) * cos(DEGTORAD(ship->heading)));
+    // move forward the ship, with the distance traveled in this step.
+    ship->x += ship->vx * dt;
+    // screen coordinates's y is opposite from traditional ones in math, vy has it already.
+    ship->y += ship->vy * dt;
     
     // if it went off the screen, they should appear on the other side of screen.
     ship->x = (ship->x < 0) ? (fmod(ship->x, BUFFER_WIDTH) + BUFFER_WIDTH) : (fmod(ship->x, BUFFER_WIDTH));
     ship->y = (ship->y < 0) ? (fmod(ship->y, BUFFER_HEIGHT) + BUFFER_HEIGHT) : (fmod(ship->y, BUFFER_HEIGHT));
-
+    _spaceship_refresh_bbox(ship);
     
     return 0;
 }
@@ -104,37 +143,42 @@ int spaceship_update(Spaceship *ship)
 /*
  Increase the speed of the ship
  */
-int spaceship_accelerate(Spaceship *ship)
+int spaceship_accelerate(Spaceship *ship, float dt)
 {
-    ship->speed = ship->speed >= MAX_SPEED ? ship->speed : (ship->speed + LINEAR_ACC);
+    ship->speed = ship->speed >= MAX_SPEED ? ship->speed : (ship->speed + LINEAR_ACC * dt * GAME_FPS);
     //ship->speed = (ship->speed + LINEAR_ACC) > MAX_SPEED ? MAX_SPEED : (ship->speed + LINEAR_ACC);
+    _spaceship_refresh_velocity(ship);
     return 0;
 }
 
 /*
  Decrease the speed of the ship
  */
-int spaceship_decelerate(Spaceship *ship)
+int spaceship_decelerate(Spaceship *ship, float dt)
 {
-    ship->speed = (ship->speed - LINEAR_ACC) <= 0 ? 0.0 : (ship->speed - LINEAR_ACC);
+    float dv = LINEAR_ACC * dt * GAME_FPS;
+    ship->speed = (ship->speed - dv) <= 0 ? 0.0 : (ship->speed - dv);
+    _spaceship_refresh_velocity(ship);
     return 0;
 }
 
 /*
  Turn heading to left (conter-clockwise), when press LEFT
  */
-int spaceship_turn_left(Spaceship *ship)
+int spaceship_turn_left(Spaceship *ship, float dt)
 {
-    ship->heading -= ANGLE_ACC;
+    ship->heading -= ANGLE_ACC * dt * GAME_FPS;
+    _spaceship_refresh_velocity(ship);
     return 0;
 }
 
 /*
  Turn heading to right (clockwise), when press RIGHT
  */
-int spaceship_turn_right(Spaceship *ship)
+int spaceship_turn_right(Spaceship *ship, float dt)
 {
-    ship->heading += ANGLE_ACC;
+    ship->heading += ANGLE_ACC * dt * GAME_FPS;
+    _spaceship_refresh_velocity(ship);
     return 0;
 }
 
@@ -144,6 +188,10 @@ int spaceship_just_hit(Spaceship *ship)
     // reset it to center of screen.
     ship->x = BUFFER_WIDTH/2.0;
     ship->y = BUFFER_HEIGHT/2.0;
+    _spaceship_refresh_bbox(ship);
+    // it jumps, don't slide it across the screen.
+    ship->prev_x = ship->x;
+    ship->prev_y = ship->y;
     return 0;
 }
 
@@ -17,12 +17,19 @@
 typedef struct {
     // position
     float x,y;
+    // position and heading at the end of last sim step, drawing interpolates from them to the current ones.
+    float prev_x, prev_y, prev_heading;
     // heading, 0-360, if ever 360, go to 1.
     float heading;
     // scale factor
     float scale;
     // spd
     float speed;
+    // cached from heading and speed, only recomputed when they change (turn, accelerate...), not every tick.
+    float dir_x, dir_y;     // unit vector of heading.
+    float vx, vy;   // in px/second.
+    // bounding box, refreshed whenever x,y changes.
+    float min_x, min_y, max_x, max_y;
     // just dead, if true, it will be wild for 3 seconds.
     float invincible_time;  // 0 for no (normal), >=1 for yes (just dead), value for total
     // color of the spaceship
@@ -36,17 +43,28 @@ int spaceship_init(Spaceship *ship, float x, float y);
 
 int spaceship_reset_to_center(Spaceship *ship);
 
-int spaceship_draw(Spaceship *ship);
+/*
+ Draw at alpha (0-1) of the way from the previous sim step to the current one.
+ */
+int spaceship_draw(Spaceship *ship, float alpha, Renderer* r);
 
-int spaceship_update(Spaceship *ship);
+/*
+ Remember the current state as the previous one, call it at the start of each sim step, before input turns the ship.
+ */
+int spaceship_keep_previous(Spaceship *ship);
 
-int spaceship_accelerate(Spaceship *ship);
+int spaceship_update(Spaceship *ship, float dt);
 
-int spaceship_decelerate(Spaceship *ship);
+/*
+ Input, dt is the sim step the key is held for.
+ */
+int spaceship_accelerate(Spaceship *ship, float dt);
 
-int spaceship_turn_left(Spaceship *ship);
+int spaceship_decelerate(Spaceship *ship, float dt);
 
-int spaceship_turn_right(Spaceship *ship);
+int spaceship_turn_left(Spaceship *ship, float dt);
+
+int spaceship_turn_right(Spaceship *ship, float dt);
 
 int spaceship_just_hit(Spaceship *ship);
 
@@ -0,0 +1,261 @@
+//
+//  sweep.c
+//  Blasteroids
+//
+//  Created by linxucc on 2020/11/30.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+#include "sweep.h"
+#include <float.h>
+#include <string.h>
+#include "common.h"
+
+// each item has 4 ends: min/max of the primary interval and of the wrapped copy.
+#define SWEEP_ENDS_PER_ITEM 4
+// insertion sort budget, past this many swaps per end on average, it's cheaper to sort it all over.
+#define SWEEP_MAX_SWAPS_PER_END 8
+
+/*
+ Sort order of the ends: by value, and when two are equal, min end goes first, so touching intervals count as overlapped, the same as bounding box test.
+ */
+bool _sweep_endpoint_less(SweepEndpoint* a, SweepEndpoint* b)
+{
+    if (a->value != b->value) {
+        return a->value < b->value;
+    }
+    return a->is_max < b->is_max;
+}
+
+int _sweep_endpoint_compare(const void* a, const void* b)
+{
+    SweepEndpoint* end_a = (SweepEndpoint*)a;
+    SweepEndpoint* end_b = (SweepEndpoint*)b;
+    if (_sweep_endpoint_less(end_a, end_b)) {
+        return -1;
+    }
+    return _sweep_endpoint_less(end_b, end_a) ? 1 : 0;
+}
+
+/*
+ Do two items overlap in y, the box may be on the other side of the top/bottom edge.
+ */
+bool _sweep_overlap_y(SweepAndPrune* sap, int a, int b)
+{
+    float shifts[3] = { 0, sap->world_height, -sap->world_height };
+    for (int s = 0; s < 3; s++) {
+        if (!(sap->min_y[a] + shifts[s] > sap->max_y[b] || sap->max_y[a] + shifts[s] < sap->min_y[b])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int _sweep_activate(SweepAndPrune* sap, int key)
+{
+    sap->active_pos[key] = sap->active_count;
+    sap->active[sap->active_count++] = key;
+    return 0;
+}
+
+int _sweep_deactivate(SweepAndPrune* sap, int key)
+{
+    // swap the last open one into the hole.
+    int pos = sap->active_pos[key];
+    int last_key = sap->active[--sap->active_count];
+    sap->active[pos] = last_key;
+    sap->active_pos[last_key] = pos;
+    sap->active_pos[key] = -1;
+    return 0;
+}
+
+int sweep_init(SweepAndPrune* sap, float world_width, float world_height)
+{
+    sap->world_width = world_width;
+    sap->world_height = world_height;
+    sap->min_x = NULL;
+    sap->min_y = NULL;
+    sap->max_x = NULL;
+    sap->max_y = NULL;
+    sap->item_count = 0;
+    sap->item_capacity = 0;
+    sap->endpoints = NULL;
+    sap->endpoint_count = 0;
+    sap->active = NULL;
+    sap->active_pos = NULL;
+    sap->active_count = 0;
+    sap->pair_results = NULL;
+    sap->item_marks = NULL;
+    sap->swaps = 0;
+    sap->full_sort = false;
+    sap->pairs_tested = 0;
+    sap->pairs_hit = 0;
+    return 0;
+}
+
+int sweep_destroy(SweepAndPrune* sap)
+{
+    free(sap->min_x);
+    free(sap->min_y);
+    free(sap->max_x);
+    free(sap->max_y);
+    free(sap->endpoints);
+    free(sap->active);
+    free(sap->active_pos);
+    free(sap->pair_results);
+    free(sap->item_marks);
+    free(sap);
+    return 0;
+}
+
+int sweep_set_item_count(SweepAndPrune* sap, int item_count)
+{
+    // only grows, so after a few ticks there's no more heap calls.
+    if (item_count > sap->item_capacity) {
+        int old_capacity = sap->item_capacity;
+        int new_capacity = old_capacity ? old_capacity : 64;
+        while (new_capacity < item_count) {
+            new_capacity *= 2;
+        }
+        char* err = "Failed when growing sweep and prune, out of memory.";
+        sap->min_x = must_realloc(sap->min_x, new_capacity * sizeof(float), err);
+        sap->min_y = must_realloc(sap->min_y, new_capacity * sizeof(float), err);
+        sap->max_x = must_realloc(sap->max_x, new_capacity * sizeof(float), err);
+        sap->max_y = must_realloc(sap->max_y, new_capacity * sizeof(float), err);
+        sap->endpoints = must_realloc(sap->endpoints, new_capacity * SWEEP_ENDS_PER_ITEM * sizeof(SweepEndpoint), err);
+        sap->active = must_realloc(sap->active, new_capacity * 2 * sizeof(int), err);
+        sap->active_pos = must_realloc(sap->active_pos, new_capacity * 2 * sizeof(int), err);
+        sap->pair_results = must_realloc(sap->pair_results, new_capacity * sizeof(int), err);
+        sap->item_marks = must_realloc(sap->item_marks, new_capacity * sizeof(unsigned char), err);
+        // new ones are not open, not marked.
+        for (int key = old_capacity * 2; key < new_capacity * 2; key++) {
+            sap->active_pos[key] = -1;
+        }
+        memset(sap->item_marks + old_capacity, 0, (new_capacity - old_capacity) * sizeof(unsigned char));
+        sap->item_capacity = new_capacity;
+    }
+
+    if (item_count < sap->item_count) {
+        // drop the ends of items no longer there, keep the rest in order.
+        int kept = 0;
+        for (int e = 0; e < sap->endpoint_count; e++) {
+            if (sap->endpoints[e].owner < item_count) {
+                sap->endpoints[kept++] = sap->endpoints[e];
+            }
+        }
+        sap->endpoint_count = kept;
+    }
+    else {
+        // append the ends of new items, values are filled and sorted in update.
+        for (int i = sap->item_count; i < item_count; i++) {
+            for (int k = 0; k < SWEEP_ENDS_PER_ITEM; k++) {
+                SweepEndpoint* end = &sap->endpoints[sap->endpoint_count++];
+                end->owner = i;
+                end->is_max = k & 1;
+                end->copy = k >> 1;
+                end->value = FLT_MAX;
+            }
+        }
+    }
+    sap->item_count = item_count;
+    return 0;
+}
+
+int sweep_update(SweepAndPrune* sap)
+{
+    // 1. refresh all the ends from the boxes.
+    for (int e = 0; e < sap->endpoint_count; e++) {
+        SweepEndpoint* end = &sap->endpoints[e];
+        int o = end->owner;
+        float value = end->is_max ? sap->max_x[o] : sap->min_x[o];
+        if (end->copy) {
+            // sticking out of the left edge, the copy is on the right side; out of the right edge, copy on the left side.
+            if (sap->min_x[o] < 0) {
+                value += sap->world_width;
+            }
+            else if (sap->max_x[o] > sap->world_width) {
+                value -= sap->world_width;
+            }
+            else {
+                // no wrapping, park the copy at the end.
+                value = FLT_MAX;
+            }
+        }
+        end->value = value;
+    }
+
+    // 2. insertion sort, nearly sorted already since last tick.
+    long swaps = 0;
+    long max_swaps = (long)sap->endpoint_count * SWEEP_MAX_SWAPS_PER_END;
+    sap->full_sort = false;
+    for (int e = 1; e < sap->endpoint_count; e++) {
+        if (swaps > max_swaps) {
+            // far from sorted, insertion sort would go O(n^2).
+            qsort(sap->endpoints, sap->endpoint_count, sizeof(SweepEndpoint), _sweep_endpoint_compare);
+            sap->full_sort = true;
+            break;
+        }
+        SweepEndpoint key = sap->endpoints[e];
+        int j = e - 1;
+        while (j >= 0 && _sweep_endpoint_less(&key, &sap->endpoints[j])) {
+            sap->endpoints[j + 1] = sap->endpoints[j];
+            j--;
+            swaps++;
+        }
+        sap->endpoints[j + 1] = key;
+    }
+    sap->swaps = swaps;
+    return 0;
+}
+
+int sweep_pairs_with_item(SweepAndPrune* sap, int item)
+{
+    int found = 0;
+    long tested = 0;
+    int item_keys[2] = { item * 2, item * 2 + 1 };
+
+    for (int e = 0; e < sap->endpoint_count; e++) {
+        SweepEndpoint* end = &sap->endpoints[e];
+        // parked copies are all at the end, nothing left to sweep.
+        if (end->value == FLT_MAX) {
+            break;
+        }
+        int key = end->owner * 2 + end->copy;
+        if (end->is_max) {
+            _sweep_deactivate(sap, key);
+            continue;
+        }
+
+        if (end->owner == item) {
+            // item opens, everything open now overlaps it in x.
+            for (int a = 0; a < sap->active_count; a++) {
+                int other = sap->active[a] / 2;
+                if (other == item) {
+                    continue;
+                }
+                tested++;
+                if (!sap->item_marks[other] && _sweep_overlap_y(sap, other, item)) {
+                    sap->item_marks[other] = 1;
+                    sap->pair_results[found++] = other;
+                }
+            }
+        }
+        else if (sap->active_pos[item_keys[0]] >= 0 || sap->active_pos[item_keys[1]] >= 0) {
+            // another one opens while item is open.
+            tested++;
+            if (!sap->item_marks[end->owner] && _sweep_overlap_y(sap, end->owner, item)) {
+                sap->item_marks[end->owner] = 1;
+                sap->pair_results[found++] = end->owner;
+            }
+        }
+        _sweep_activate(sap, key);
+    }
+
+    // every interval that opened has closed, only the marks need to be cleared.
+    for (int k = 0; k < found; k++) {
+        sap->item_marks[sap->pair_results[k]] = 0;
+    }
+    sap->pairs_tested = tested;
+    sap->pairs_hit = found;
+    return found;
+}
@@ -0,0 +1,98 @@
+//
+//  sweep.h
+//  Blasteroids
+//
+//  Created by linxucc on 2020/11/30.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+/*
+ Sweep and prune broadphase on x axis, aware of the screen wraparound.
+ 
+ The world is a torus: whatever goes out of one edge comes back from the other side, so a box sticking out of the right edge also covers the left edge.
+ Such a box is duplicated: its primary interval stays where it is, a copy shifted by the world width covers the other side. A box that doesn't stick out has its copy parked at the very end (FLT_MAX), where the sweep never opens it.
+ 
+ All the min/max ends of all the intervals are kept in one list, sorted by x. The list is kept across ticks, things only move a little between two ticks, so re-sorting it with insertion sort is almost O(n).
+ When it's far from sorted (a lot of new items, or so many items that they pass each other all the time), insertion sort gives up after SWEEP_MAX_SWAPS_PER_END swaps per end, and a full sort takes over.
+ 
+ How to use, each tick:
+    1. sweep_set_item_count(), then fill min_x/min_y/max_x/max_y of every item.
+    2. sweep_update(), re-sort the ends.
+    3. sweep_pairs_with_item() to find who overlaps an item.
+ 
+ Items are only referred by their index.
+ */
+
+#ifndef sweep_h
+#define sweep_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+/*
+ One end of an interval.
+ */
+typedef struct {
+    float value;    // x of this end.
+    int owner;      // the item this end belongs to.
+    unsigned char is_max;   // 0 == min end, 1 == max end.
+    unsigned char copy;     // 0 == primary interval, 1 == the wrapped copy.
+} SweepEndpoint;
+
+typedef struct {
+    float world_width;
+    float world_height;
+
+    // bounding boxes of the items, filled by caller before update, indexed by item.
+    float* min_x;
+    float* min_y;
+    float* max_x;
+    float* max_y;
+    int item_count;
+    int item_capacity;
+
+    // 4 ends per item (min/max of primary and copy), sorted by value, kept across ticks.
+    SweepEndpoint* endpoints;
+    int endpoint_count;
+
+    // open intervals while sweeping, as owner * 2 + copy. active_pos tells where an interval is in active, -1 == not open.
+    int* active;
+    int* active_pos;
+    int active_count;
+
+    // result of the last pairs query, item indices, each item appears once.
+    int* pair_results;
+    unsigned char* item_marks;
+
+    // stats of the last update and query.
+    long swaps;     // moves done by insertion sort.
+    bool full_sort; // insertion sort gave up.
+    long pairs_tested;  // intervals met while sweeping, tested in y.
+    long pairs_hit;
+} SweepAndPrune;
+
+int sweep_init(SweepAndPrune* sap, float world_width, float world_height);
+
+int sweep_destroy(SweepAndPrune* sap);
+
+/*
+ Make room for item_count items, caller should fill the boxes of all of them afterwards.
+ Ends of the items no longer there are dropped, ends of the new items are appended, update will sort them in.
+ */
+int sweep_set_item_count(SweepAndPrune* sap, int item_count);
+
+/*
+ Refresh every end from the boxes, duplicate the wrapping ones, then insertion sort, or a full sort if it's far from sorted.
+ */
+int sweep_update(SweepAndPrune* sap);
+
+/*
+ Find all the items overlapping item, with wraparound in both x and y.
+ 
+ Return how many are found, their indices are in sap->pair_results, in x order.
+ */
+int sweep_pairs_with_item(SweepAndPrune* sap, int item);
+
+
+#endif /* sweep_h */
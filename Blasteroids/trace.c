@@ -0,0 +1,124 @@
+//
+//  trace.c
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/08.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+#include "trace.h"
+#include <stdlib.h>
+#include <time.h>
+#include <stdatomic.h>
+#include "common.h"
+
+static TraceEvent* events = NULL;
+static uint64_t event_mask = 0;     // capacity - 1, capacity is a power of 2.
+static _Atomic uint64_t event_total = 0;    // ever recorded, the next one goes to event_total & event_mask.
+static _Thread_local int current_thread = 1;
+static uint64_t origin_ns = 0;      // clock at trace_init(), every start is from it.
+
+uint64_t _trace_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+int trace_init(int capacity)
+{
+    uint64_t rounded = 1;
+    while (rounded < (uint64_t)capacity) {
+        rounded *= 2;
+    }
+    free(events);
+    events = malloc(rounded * sizeof(TraceEvent));
+    if (!events) {
+        go_error("Failed when allocating trace events, out of memory.");
+    }
+    event_mask = rounded - 1;
+    event_total = 0;
+    // minus one, so that the very first begin isn't 0, which means "off".
+    origin_ns = _trace_now_ns() - 1;
+    return 0;
+}
+
+int trace_destroy(void)
+{
+    free(events);
+    events = NULL;
+    return 0;
+}
+
+uint64_t trace_begin(void)
+{
+    if (!events) {
+        return 0;
+    }
+    return _trace_now_ns() - origin_ns;
+}
+
+void trace_end(const char* name, uint64_t start)
+{
+    if (!events || !start) {
+        return;
+    }
+    uint64_t end = _trace_now_ns() - origin_ns;
+    TraceEvent* e = &events[atomic_fetch_add(&event_total, 1) & event_mask];
+    e->name = name;
+    e->start_ns = start;
+    e->duration_ns = end - start;
+    e->thread = current_thread;
+}
+
+void trace_set_thread(int thread)
+{
+    current_thread = thread;
+}
+
+int trace_write_json(const char* path)
+{
+    if (!events) {
+        return 1;
+    }
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        printf("can't write trace to %s.\n", path);
+        return 1;
+    }
+    // once wrapped around, the oldest one is where the next one goes.
+    uint64_t capacity = event_mask + 1;
+    uint64_t total = event_total;
+    uint64_t first = total > capacity ? total - capacity : 0;
+    // "X" is a complete event, start and duration in one, times are in us.
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (uint64_t i = first; i < total; i++) {
+        TraceEvent* e = &events[i & event_mask];
+        fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+                e->name,
+                e->thread,
+                e->start_ns / 1000.0,
+                e->duration_ns / 1000.0,
+                i + 1 < total ? "," : "");
+    }
+    fprintf(file, "]}\n");
+    fclose(file);
+    if (VERBOSE) {
+        printf("trace: %llu events written to %s\n", (unsigned long long)(total - first), path);
+    }
+    return 0;
+}
+
+int trace_print_stats(void)
+{
+    if (!events) {
+        return 0;
+    }
+    uint64_t capacity = event_mask + 1;
+    uint64_t total = event_total;
+    printf("trace: %llu events recorded, ring of %llu, %llu overwritten\n",
+           (unsigned long long)total,
+           (unsigned long long)capacity,
+           (unsigned long long)(total > capacity ? total - capacity : 0));
+    return 0;
+}
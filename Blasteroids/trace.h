@@ -0,0 +1,76 @@
+//
+//  trace.h
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/08.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+/*
+ Timing of the hot path, for finding out where a frame's time goes.
+ 
+ A timed scope is a pair around the code:
+    uint64_t t = trace_begin();
+    ...
+    trace_end("name", t);
+ Each pair is one event, name, start and duration on the monotonic clock, written into a ring of events allocated once by trace_init(). When it's full the oldest events are overwritten, so recording never goes to the heap and the ring always holds the latest ones.
+ Until trace_init() is called tracing is off, a pair is then just a check of a flag.
+ 
+ trace_write_json() dumps the ring in the Chrome trace event format, open it in chrome://tracing or Perfetto.
+ 
+ The ring is one for the whole program, names have to be string literals (only the pointer is kept).
+ Any thread could record, each takes its slot with one atomic add, trace_set_thread() names which track of the trace its events go to. Writing the JSON while others are still recording may catch an event half written, stop them first for an exact dump.
+ */
+
+#ifndef trace_h
+#define trace_h
+
+#include <stdio.h>
+#include <stdint.h>
+
+typedef struct {
+    const char* name;
+    uint64_t start_ns;  // since trace_init().
+    uint64_t duration_ns;
+    int thread;
+} TraceEvent;
+
+/*
+ Start tracing into a ring of capacity events, rounded up to a power of 2.
+ */
+int trace_init(int capacity);
+
+/*
+ Stop tracing, free the ring.
+ */
+int trace_destroy(void);
+
+/*
+ Events recorded from the calling thread go to track thread from now on, the main thread is 1.
+ */
+void trace_set_thread(int thread);
+
+/*
+ Start of a timed scope, pass the return value to trace_end(). 0 when tracing is off.
+ */
+uint64_t trace_begin(void);
+
+/*
+ End of a timed scope started at start, records one event named name.
+ */
+void trace_end(const char* name, uint64_t start);
+
+/*
+ Write every event in the ring, oldest first, to path as Chrome trace JSON.
+ 
+ Return 0 on success, 1 if tracing is off or the file can't be written.
+ */
+int trace_write_json(const char* path);
+
+/*
+ How many events are recorded, and how many are lost to the ring wrapping around.
+ */
+int trace_print_stats(void);
+
+
+#endif /* trace_h */
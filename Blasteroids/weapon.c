@@ -0,0 +1,62 @@
+//
+//  weapon.c
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/09.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+#include "weapon.h"
+#include <math.h>
+#include "common.h"
+
+// dt doesn't add up to cooldown exactly in float, this little left is cooled down already.
+#define WEAPON_COOLDOWN_SLACK 1e-4f
+
+int weapon_init(Weapon* weapon, float cooldown, float lifetime)
+{
+    weapon->cooldown = cooldown;
+    weapon->lifetime = lifetime;
+    weapon->cooldown_left = 0;  // ready from the start.
+    weapon->fired = 0;
+    weapon->held = 0;
+    return 0;
+}
+
+int weapon_destroy(Weapon* weapon)
+{
+    free(weapon);
+    return 0;
+}
+
+bool weapon_fire(Weapon* weapon, CommandBuffer* commands, Spaceship* ship)
+{
+    if (weapon->cooldown_left > WEAPON_COOLDOWN_SLACK) {
+        weapon->held++;
+        return false;
+    }
+    blastcluster_record_blast(commands, ship, weapon->lifetime);
+    weapon->cooldown_left = weapon->cooldown;
+    weapon->fired++;
+    return true;
+}
+
+int weapon_update(Weapon* weapon, float dt)
+{
+    if (weapon->cooldown_left > 0) {
+        weapon->cooldown_left -= dt;
+    }
+    return 0;
+}
+
+int weapon_ring_capacity(float cooldown, float lifetime)
+{
+    int capacity = (int)ceilf(lifetime / cooldown) + 1;
+    return capacity > BLAST_CAPACITY ? capacity : BLAST_CAPACITY;
+}
+
+int weapon_print_stats(Weapon* weapon)
+{
+    printf("weapon: cooldown %.3f s, blast lifetime %.3f s, fired %ld, held back %ld\n", weapon->cooldown, weapon->lifetime, weapon->fired, weapon->held);
+    return 0;
+}
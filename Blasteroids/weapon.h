@@ -0,0 +1,57 @@
+//
+//  weapon.h
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/09.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+/*
+ Weapon, how often the ship can fire and how long a blast flies.
+ 
+ Holding fire fires once every cooldown seconds, not every tick. Every blast is gone after lifetime seconds, if it hasn't hit anything or left the screen yet.
+ So at most lifetime / cooldown blasts of it are in the air, the blast cluster's ring is sized for that (weapon_ring_capacity()).
+ Both come from the config (--cooldown, --blast-life), defaults WEAPON_COOLDOWN and BLAST_LIFETIME, a replay brings its own.
+ 
+ The cooldown is part of the game, it's in the snapshot, a replay fires at the same ticks.
+ */
+
+#ifndef weapon_h
+#define weapon_h
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "blast.h"
+#include "spaceship.h"
+
+typedef struct {
+    float cooldown;     // in seconds, between two blasts.
+    float lifetime;     // in seconds, of a blast.
+    float cooldown_left;    // in seconds, it fires again when it's down to 0.
+    long fired;
+    long held;  // fire pressed while cooling down.
+} Weapon;
+
+int weapon_init(Weapon* weapon, float cooldown, float lifetime);
+
+int weapon_destroy(Weapon* weapon);
+
+/*
+ Fire a blast from ship if it has cooled down, return true if it did. It's recorded into commands, the blast cluster adds it when they're applied (blastcluster_apply()).
+ */
+bool weapon_fire(Weapon* weapon, CommandBuffer* commands, Spaceship* ship);
+
+/*
+ Cool down by dt seconds.
+ */
+int weapon_update(Weapon* weapon, float dt);
+
+/*
+ Room the blast ring needs for every blast of a weapon of cooldown and lifetime, at least BLAST_CAPACITY.
+ */
+int weapon_ring_capacity(float cooldown, float lifetime);
+
+int weapon_print_stats(Weapon* weapon);
+
+
+#endif /* weapon_h */
@@ -0,0 +1,156 @@
+//
+//  worker_pool.c
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/09.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+#include "worker_pool.h"
+#include <stdlib.h>
+#include "common.h"
+
+typedef struct {
+    WorkerPool* pool;
+    int index;  // 1.., slice 0 is the caller's.
+} WorkerStart;
+
+/*
+ Do the slice of thread index, if there's anything left for it.
+ */
+void _worker_pool_do_slice(WorkerPool* pool, int index)
+{
+    int begin = index * pool->slice;
+    int end = begin + pool->slice < pool->count ? begin + pool->slice : pool->count;
+    if (begin < end) {
+        pool->task(pool->context, index, begin, end);
+    }
+}
+
+void* _worker_pool_thread(void* arg)
+{
+    WorkerStart start = *(WorkerStart*)arg;
+    free(arg);
+    WorkerPool* pool = start.pool;
+    long seen_generation = 0;
+    
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        // sleep till there's a new run, or it's time to quit.
+        while (!pool->quit && pool->generation == seen_generation) {
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+        }
+        if (pool->quit) {
+            break;
+        }
+        seen_generation = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+        
+        _worker_pool_do_slice(pool, start.index);
+        
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) {
+            pthread_cond_signal(&pool->work_done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+int worker_pool_init(WorkerPool* pool, int thread_count)
+{
+    if (thread_count < 1) {
+        thread_count = 1;
+    }
+    if (thread_count > WORKER_POOL_MAX_THREADS) {
+        thread_count = WORKER_POOL_MAX_THREADS;
+    }
+    pool->thread_count = thread_count;
+    pool->task = NULL;
+    pool->context = NULL;
+    pool->count = 0;
+    pool->slice = 0;
+    pool->generation = 0;
+    pool->pending = 0;
+    pool->quit = false;
+    pool->parallel_runs = 0;
+    pool->serial_runs = 0;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+    
+    pool->threads = malloc(thread_count * sizeof(pthread_t));
+    if (!pool->threads) {
+        go_error("Failed when allocating worker threads, out of memory.");
+    }
+    for (int i = 0; i < thread_count - 1; i++) {
+        WorkerStart* start = malloc(sizeof(WorkerStart));
+        start->pool = pool;
+        start->index = i + 1;
+        if (pthread_create(&pool->threads[i], NULL, _worker_pool_thread, start) != 0) {
+            go_error("Failed when starting worker thread.");
+        }
+    }
+    return 0;
+}
+
+int worker_pool_destroy(WorkerPool* pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->thread_count - 1; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_cond_destroy(&pool->work_done);
+    free(pool->threads);
+    free(pool);
+    return 0;
+}
+
+int worker_pool_run(WorkerPool* pool, WorkerTask task, void* context, int count, int min_count)
+{
+    if (count <= 0) {
+        return 0;
+    }
+    if (pool->thread_count == 1 || count < min_count) {
+        task(context, 0, 0, count);
+        pool->serial_runs++;
+        return 0;
+    }
+    
+    // even slices, rounded up to whole cache lines, the last one takes what's left.
+    int slice = (count + pool->thread_count - 1) / pool->thread_count;
+    slice = (slice + WORKER_POOL_ALIGN - 1) / WORKER_POOL_ALIGN * WORKER_POOL_ALIGN;
+    
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->context = context;
+    pool->count = count;
+    pool->slice = slice;
+    pool->pending = pool->thread_count - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+    
+    // the caller is worker 0.
+    _worker_pool_do_slice(pool, 0);
+    
+    // barrier, everyone's done before anything after reads the results.
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->work_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    pool->parallel_runs++;
+    return 0;
+}
+
+int worker_pool_print_stats(WorkerPool* pool)
+{
+    printf("workers: %d threads, %ld parallel runs, %ld serial runs\n", pool->thread_count, pool->parallel_runs, pool->serial_runs);
+    return 0;
+}
@@ -0,0 +1,76 @@
+//
+//  worker_pool.h
+//  Blasteroids
+//
+//  Created by linxucc on 2020/12/09.
+//  Copyright © 2020 lin. All rights reserved.
+//
+
+/*
+ Pool of worker threads, for running one loop over many elements in parallel.
+ 
+ The threads are started once and sleep in between, so a run costs a wake up, not a thread creation.
+ worker_pool_run() splits [0, count) into one slice per thread, the calling thread takes the first one itself, and only returns when every slice is done. That's the barrier: whatever comes after sees all of the results.
+ 
+ Slices are cut at multiples of WORKER_POOL_ALIGN elements, with 4 byte elements and arrays starting on a cache line, no two threads ever write the same cache line.
+ Each element is done by the same code no matter which thread gets it, so results are bit-identical to a serial loop.
+ 
+ Below min_count elements, or with only 1 thread, the task just runs serially on the caller.
+ */
+
+#ifndef worker_pool_h
+#define worker_pool_h
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+// slices are cut at multiples of this many elements, 16 floats == a 64 byte cache line.
+#define WORKER_POOL_ALIGN 16
+#define WORKER_POOL_MAX_THREADS 64
+
+/*
+ Do elements [begin, end) of the work context describes. worker is which thread it's on, 0 to thread_count - 1, for picking per thread scratch.
+ */
+typedef void (*WorkerTask)(void* context, int worker, int begin, int end);
+
+typedef struct {
+    pthread_t* threads;     // thread_count - 1 of them, the caller is the first worker.
+    int thread_count;
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    
+    // the run in progress.
+    WorkerTask task;
+    void* context;
+    int count;
+    int slice;      // elements each thread takes.
+    long generation;    // bumped by every run, workers wake up on it.
+    int pending;    // workers not yet done with this run.
+    bool quit;
+    
+    // stats.
+    long parallel_runs;
+    long serial_runs;
+} WorkerPool;
+
+/*
+ Start thread_count - 1 threads, 1 or less means no threads, every run is serial.
+ */
+int worker_pool_init(WorkerPool* pool, int thread_count);
+
+/*
+ Stop and join the threads, free the pool.
+ */
+int worker_pool_destroy(WorkerPool* pool);
+
+/*
+ Run task over [0, count) on every thread, return when all done. Serial if count < min_count.
+ */
+int worker_pool_run(WorkerPool* pool, WorkerTask task, void* context, int count, int min_count);
+
+int worker_pool_print_stats(WorkerPool* pool);
+
+
+#endif /* worker_pool_h */